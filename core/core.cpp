@@ -72,6 +72,7 @@ namespace NV1Sim
 
         settings.vram_amount = 0x400000;    // the full 4MB 
         settings.straps = 0x7;              // test 
+        settings.pfifo_thread = true;       // keep method execution off the UI thread
 
         gpu = new NV1(settings);
 
@@ -112,6 +113,9 @@ namespace NV1Sim
 
     bool Game_Shutdown()
     {
+        if (gpu)
+            gpu->Stop();
+
         SDL_DestroyRenderer(game.renderer);
         SDL_DestroyWindow(game.window);
 
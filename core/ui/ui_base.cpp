@@ -22,6 +22,17 @@ namespace NV1Sim
         ImGui::Text("PMC_INTR = 0x%0x", gpu->pmc.intr);
         ImGui::Text("PMC_INTR_EN = 0x%0x", gpu->pmc.intr_en);
         ImGui::Text("PMC_ENABLE = 0x%0x", gpu->pmc.enable);
+
+        ImGui::SeparatorText("PFIFO:");
+        ImGui::Text("RAMHT cache hits = %llu", (unsigned long long)gpu->pfifo.ramht_cache.hits.load(std::memory_order_relaxed));
+        ImGui::Text("RAMHT cache misses = %llu", (unsigned long long)gpu->pfifo.ramht_cache.misses.load(std::memory_order_relaxed));
+        ImGui::Text("RAMRO entries = %llu", (unsigned long long)gpu->pfifo.runout_entries.load(std::memory_order_relaxed));
+        ImGui::Text("RAMRO overflows = %llu", (unsigned long long)gpu->pfifo.runout_overflows.load(std::memory_order_relaxed));
+
+        ImGui::SeparatorText("PGRAPH:");
+        ImGui::Text("Clip accepted = %llu", (unsigned long long)gpu->state.clip.accepted.load(std::memory_order_relaxed));
+        ImGui::Text("Clip trimmed = %llu", (unsigned long long)gpu->state.clip.trimmed.load(std::memory_order_relaxed));
+        ImGui::Text("Clip rejected = %llu", (unsigned long long)gpu->state.clip.rejected.load(std::memory_order_relaxed));
         ImGui::End();
     }
 
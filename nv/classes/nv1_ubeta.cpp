@@ -10,8 +10,17 @@
 
 namespace NV1Sim
 {
-    class NV1UBeta : NV1UBase
+    void NV1UBeta::Method(uint32_t offset, uint32_t param)
     {
-        uint32_t beta_factor;
-    };
-}
\ No newline at end of file
+        switch (offset)
+        {
+            // 1.31, but NV_PGRAPH_BETA only keeps 8 bits of fraction and can't be negative
+            case NV1_CLASS_METHOD(NV_UBETA_SET_BETA1D31):
+                gpu->pgraph.beta = (param & 0x80000000) ? 0 : (param & 0x7F800000);
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+}
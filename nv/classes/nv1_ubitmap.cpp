@@ -0,0 +1,103 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_ubitmap.cpp: Monochrome bitmaps
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1UBitmap::Method(uint32_t offset, uint32_t param)
+    {
+        if (offset >= NV1_CLASS_METHOD(NV_UBITMAP_MONOCHROME(0))
+        && offset < NV1_CLASS_METHOD(NV_UBITMAP_MONOCHROME(NV_UBITMAP_MONOCHROME__SIZE_1)))
+        {
+            Monochrome(param);
+            return;
+        }
+
+        switch (offset)
+        {
+            // the colours are in the framebuffer's format, like every other object colour. MONO_COLOR keeps them in the
+            // internal format, with bit 30 for whether they're opaque
+            case NV1_CLASS_METHOD(NV_UBITMAP_COLOR0):
+                gpu->pgraph.mono_color0 = gpu->PGRAPHObjectColor(param, gpu->PGRAPHGetSurface());
+                break;
+            case NV1_CLASS_METHOD(NV_UBITMAP_COLOR1):
+                gpu->pgraph.mono_color1 = gpu->PGRAPHObjectColor(param, gpu->PGRAPHGetSurface());
+                break;
+            case NV1_CLASS_METHOD(NV_UBITMAP_POINT):
+                x = (int16_t)(param & 0xFFFF);
+                y = (int16_t)(param >> 16);
+                break;
+            case NV1_CLASS_METHOD(NV_UBITMAP_SIZE):
+                width = param & 0xFFFF;
+                height = param >> 16;
+                break;
+            // the input size goes last and starts a new bitmap
+            case NV1_CLASS_METHOD(NV_UBITMAP_SIZE_IN):
+                width_in = param & 0xFFFF;
+                height_in = param >> 16;
+
+                line = 0;
+                line_pixels = 0;
+                staging_pixel = 0;
+                staging_pixels = 0;
+
+                gpu->PGRAPHCountClip(x, y, std::min(width, width_in), std::min(height, height_in));
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+
+    // Each MONOCHROME word is 32 pixels
+    void NV1UBitmap::Monochrome(uint32_t param)
+    {
+        // the whole bitmap has already arrived
+        if (line >= height_in
+        || !width_in)
+            return;
+
+        if (staging_pixels + 32 > NV1_UBITMAP_STAGING_SIZE * 8)
+            CommitStaging();
+
+        // CGA6 has the leftmost pixel in bit 7 of each byte rather than bit 0
+        if ((gpu->pgraph.ctx_switch >> 14) & 0x01)
+        {
+            param = ((param >> 1) & 0x55555555) | ((param & 0x55555555) << 1);
+            param = ((param >> 2) & 0x33333333) | ((param & 0x33333333) << 2);
+            param = ((param >> 4) & 0x0F0F0F0F) | ((param & 0x0F0F0F0F) << 4);
+        }
+
+        uint32_t count = std::min<uint32_t>(32, width_in - line_pixels);
+
+        memcpy(staging + (staging_pixels >> 3), &param, sizeof(param));
+        staging_pixels += count;
+        line_pixels += count;
+
+        if (line_pixels == width_in)
+        {
+            CommitStaging();
+            line++;
+            line_pixels = 0;
+            staging_pixel = 0;
+        }
+    }
+
+    // Draw what has been received of the current line. Lines wider than staging are drawn in pieces
+    void NV1UBitmap::CommitStaging()
+    {
+        // only SIZE of the bitmap is drawn, the rest is thrown away
+        if (line < height
+        && staging_pixel < width)
+            gpu->PGRAPHMonoLine(x + staging_pixel, y + line, std::min(staging_pixels, width - staging_pixel), staging);
+
+        staging_pixel += staging_pixels;
+        staging_pixels = 0;
+    }
+}
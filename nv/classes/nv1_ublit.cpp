@@ -0,0 +1,33 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_ublit.cpp: Screen to screen blit
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1UBlit::Method(uint32_t offset, uint32_t param)
+    {
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UBLIT_POINT_IN):
+                point_in = param;
+                break;
+            case NV1_CLASS_METHOD(NV_UBLIT_POINT_OUT):
+                point_out = param;
+                break;
+            // the size goes last and starts the blit
+            case NV1_CLASS_METHOD(NV_UBLIT_SIZE):
+                gpu->PGRAPHBlit((int16_t)(point_in & 0xFFFF), (int16_t)(point_in >> 16), (int16_t)(point_out & 0xFFFF), (int16_t)(point_out >> 16),
+                    param & 0xFFFF, param >> 16);
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+}
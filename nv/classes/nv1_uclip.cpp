@@ -0,0 +1,31 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_uclip.cpp: User clip rectangle
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    // The rectangle is sent as a corner and then a size. The clip rectangle is worked out again the next time something is drawn
+    void NV1UClip::Method(uint32_t offset, uint32_t param)
+    {
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UCLIP_SET_RECT_0):
+                gpu->pgraph.abs_uclip_xmin = (int16_t)(param & 0xFFFF);
+                gpu->pgraph.abs_uclip_ymin = (int16_t)(param >> 16);
+                break;
+            case NV1_CLASS_METHOD(NV_UCLIP_SET_RECT_1):
+                gpu->pgraph.abs_uclip_xmax = gpu->pgraph.abs_uclip_xmin + (param & 0xFFFF);
+                gpu->pgraph.abs_uclip_ymax = gpu->pgraph.abs_uclip_ymin + (param >> 16);
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_ufromem.cpp: Images from memory
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1UFromem::Method(uint32_t offset, uint32_t param)
+    {
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UFROMEM_POINT):
+                point = param;
+                break;
+            case NV1_CLASS_METHOD(NV_UFROMEM_SIZE):
+                size = param;
+                break;
+            case NV1_CLASS_METHOD(NV_UFROMEM_PITCH):
+                pitch = (int32_t)param;
+                break;
+            case NV1_CLASS_METHOD(NV_UFROMEM_IMAGE_START):
+                Transfer(param);
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+
+    // Draw the image starting at start. DMA isn't there yet, so start is an offset into VRAM.
+    // Every line goes through staging first, because the image can overlap where it's being drawn
+    void NV1UFromem::Transfer(uint32_t start)
+    {
+        uint32_t bytes_per_pixel = gpu->PGRAPHGetSurface().bytes_per_pixel;
+
+        if (!bytes_per_pixel)
+            return;
+
+        int32_t x = (int16_t)(point & 0xFFFF);
+        int32_t y = (int16_t)(point >> 16);
+        uint32_t width = size & 0xFFFF;
+        uint32_t height = size >> 16;
+        uint32_t staging_pixels = sizeof(staging) / bytes_per_pixel;
+
+        gpu->PGRAPHCountClip(x, y, width, height);
+
+        for (uint32_t line = 0; line < height; line++)
+        {
+            int64_t line_start = (int64_t)start + (int64_t)line * pitch;
+
+            for (uint32_t pixel = 0; pixel < width; pixel += staging_pixels)
+            {
+                uint32_t count = std::min(width - pixel, staging_pixels);
+                int64_t addr = line_start + pixel * bytes_per_pixel;
+
+                if (addr < 0
+                || addr + count * bytes_per_pixel > gpu->settings.vram_amount)
+                {
+                    Logging_LogChannel("UFROMEM: Image at 0x%08x goes outside VRAM", LogChannel::Debug, start);
+                    return;
+                }
+
+                memcpy(staging, gpu->state.video_ram8 + addr, count * bytes_per_pixel);
+                gpu->PGRAPHImageLine(x + pixel, y + line, count, staging);
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_uimage.cpp: Images from the CPU
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1UImage::Method(uint32_t offset, uint32_t param)
+    {
+        if (offset >= NV1_CLASS_METHOD(NV_UIMAGE_COLOR(0))
+        && offset < NV1_CLASS_METHOD(NV_UIMAGE_COLOR(NV_UIMAGE_COLOR__SIZE_1)))
+        {
+            Color(param);
+            return;
+        }
+
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UIMAGE_POINT):
+                x = (int16_t)(param & 0xFFFF);
+                y = (int16_t)(param >> 16);
+                break;
+            case NV1_CLASS_METHOD(NV_UIMAGE_SIZE):
+                width = param & 0xFFFF;
+                height = param >> 16;
+                break;
+            // the input size goes last and starts a new image
+            case NV1_CLASS_METHOD(NV_UIMAGE_SIZE_IN):
+                width_in = param & 0xFFFF;
+                height_in = param >> 16;
+
+                bytes_per_pixel = gpu->PGRAPHGetSurface().bytes_per_pixel;
+                line = 0;
+                line_bytes = width_in * bytes_per_pixel;
+                line_offset = 0;
+                staging_pixel = 0;
+                staging_bytes = 0;
+
+                gpu->PGRAPHCountClip(x, y, std::min(width, width_in), std::min(height, height_in));
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+
+    // Each COLOR word has as many pixels as fit in 32 bits at the framebuffer's depth, so unpacking it is just a copy
+    void NV1UImage::Color(uint32_t param)
+    {
+        // the whole image has already arrived
+        if (line >= height_in
+        || !line_bytes)
+            return;
+
+        if (staging_bytes + sizeof(param) > sizeof(staging))
+            CommitStaging();
+
+        uint32_t count = std::min<uint32_t>(sizeof(param), line_bytes - line_offset);
+
+        memcpy(staging + staging_bytes, &param, count);
+        staging_bytes += count;
+        line_offset += count;
+
+        if (line_offset == line_bytes)
+        {
+            CommitStaging();
+            line++;
+            line_offset = 0;
+            staging_pixel = 0;
+        }
+    }
+
+    // Draw what has been received of the current line. Lines wider than staging are drawn in pieces
+    void NV1UImage::CommitStaging()
+    {
+        uint32_t pixels = staging_bytes / bytes_per_pixel;
+
+        // only SIZE of the image is drawn, the rest is thrown away
+        if (line < height
+        && staging_pixel < width)
+            gpu->PGRAPHImageLine(x + staging_pixel, y + line, std::min(pixels, width - staging_pixel), staging);
+
+        staging_pixel += pixels;
+        staging_bytes = 0;
+    }
+}
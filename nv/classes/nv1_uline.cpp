@@ -0,0 +1,119 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_uline.cpp: Lines and polylines (NV_ULINE and NV_ULIN)
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1ULine::Method(uint32_t offset, uint32_t param)
+    {
+        // NV_ULIN has the same methods at the same offsets
+        if (offset >= NV1_CLASS_METHOD(NV_ULINE_LINE_0(0))
+        && offset < NV1_CLASS_METHOD(NV_ULINE_LINE_0(NV_ULINE_LINE_0__SIZE_1)))
+        {
+            if (offset & 0x04)
+                Line(start_x, start_y, (int16_t)(param & 0xFFFF), (int16_t)(param >> 16), color);
+            else
+            {
+                start_x = (int16_t)(param & 0xFFFF);
+                start_y = (int16_t)(param >> 16);
+            }
+
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_ULINE_LINE32_0(0))
+        && offset < NV1_CLASS_METHOD(NV_ULINE_LINE32_0(NV_ULINE_LINE32_0__SIZE_1)))
+        {
+            switch (offset & 0x0C)
+            {
+                case 0x00:
+                    start_x = (int32_t)param;
+                    break;
+                case 0x04:
+                    start_y = (int32_t)param;
+                    break;
+                case 0x08:
+                    end_x = (int32_t)param;
+                    break;
+                case 0x0C:
+                    Line(start_x, start_y, end_x, (int32_t)param, color);
+                    break;
+            }
+
+            return;
+        }
+
+        // The first vertex of a polyline is the one written to index 0, so longer polylines have to send their last vertex again
+        if (offset >= NV1_CLASS_METHOD(NV_ULINE_POLYLINE(0))
+        && offset < NV1_CLASS_METHOD(NV_ULINE_POLYLINE(NV_ULINE_POLYLINE__SIZE_1)))
+        {
+            PolylineVertex((offset - NV1_CLASS_METHOD(NV_ULINE_POLYLINE(0))) >> 2, (int16_t)(param & 0xFFFF), (int16_t)(param >> 16), color);
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_ULINE_POLYLINE32_0(0))
+        && offset < NV1_CLASS_METHOD(NV_ULINE_POLYLINE32_0(NV_ULINE_POLYLINE32_0__SIZE_1)))
+        {
+            // Y goes last
+            if (offset & 0x04)
+                PolylineVertex((offset - NV1_CLASS_METHOD(NV_ULINE_POLYLINE32_0(0))) >> 3, end_x, (int32_t)param, color);
+            else
+                end_x = (int32_t)param;
+
+            return;
+        }
+
+        // Each vertex has the colour of the segment that ends at it
+        if (offset >= NV1_CLASS_METHOD(NV_ULINE_CPOLYLINE_0(0))
+        && offset < NV1_CLASS_METHOD(NV_ULINE_CPOLYLINE_0(NV_ULINE_CPOLYLINE_0__SIZE_1)))
+        {
+            if (offset & 0x04)
+                PolylineVertex((offset - NV1_CLASS_METHOD(NV_ULINE_CPOLYLINE_0(0))) >> 3, (int16_t)(param & 0xFFFF), (int16_t)(param >> 16), cpolyline_color);
+            else
+                cpolyline_color = param;
+
+            return;
+        }
+
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_ULINE_COLOR):
+                color = param;
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+
+    void NV1ULine::PolylineVertex(uint32_t index, int32_t x, int32_t y, uint32_t line_color)
+    {
+        if (index)
+            Line(start_x, start_y, x, y, line_color);
+
+        start_x = x;
+        start_y = y;
+    }
+
+    // Lines aren't drawn straight away. They are queued up until the batch is full or something else needs PGRAPH
+    void NV1ULine::Line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t line_color)
+    {
+        if (batch_lines == NV1_PGRAPH_LINE_BATCH_SIZE)
+            Flush();
+
+        batch[batch_lines++] = { x0, y0, x1, y1, line_color };
+        gpu->pgraph.batch_object = this;
+    }
+
+    void NV1ULine::Flush()
+    {
+        gpu->PGRAPHLines(std::span(batch, batch_lines), last_pixel);
+        batch_lines = 0;
+    }
+}
@@ -0,0 +1,52 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_upatt.cpp: Pattern
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    // The pattern is a 64-bit mono bitmap in one of three shapes, drawn with two colours. It's expanded again the next
+    // time it's used after any of it changes
+    void NV1UPatt::Method(uint32_t offset, uint32_t param)
+    {
+        if (offset >= NV1_CLASS_METHOD(NV_UPATT_SET_PATTERN(0))
+        && offset < NV1_CLASS_METHOD(NV_UPATT_SET_PATTERN(NV_UPATT_SET_PATTERN__SIZE_1)))
+        {
+            gpu->pgraph.pattern_bitmap[(offset - NV1_CLASS_METHOD(NV_UPATT_SET_PATTERN(0))) >> 2] = param;
+            return;
+        }
+
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UPATT_SET_SHAPE):
+                gpu->pgraph.pattern_shape = param & 0x03;
+                break;
+            // the colours are in the framebuffer's format, like every other object colour. Bit 30 says whether the colour
+            // is opaque, and pattern pixels in a transparent colour aren't drawn
+            case NV1_CLASS_METHOD(NV_UPATT_SET_COLOR0):
+            {
+                uint32_t color = gpu->PGRAPHObjectColor(param, gpu->PGRAPHGetSurface());
+
+                gpu->pgraph.patt_0_rgb = color & 0x3FFFFFFF;
+                gpu->pgraph.patt_0_a = ((color >> 30) & 0x01) ? 0xFF : 0x00;
+                break;
+            }
+            case NV1_CLASS_METHOD(NV_UPATT_SET_COLOR1):
+            {
+                uint32_t color = gpu->PGRAPHObjectColor(param, gpu->PGRAPHGetSurface());
+
+                gpu->pgraph.patt_1_rgb = color & 0x3FFFFFFF;
+                gpu->pgraph.patt_1_a = ((color >> 30) & 0x01) ? 0xFF : 0x00;
+                break;
+            }
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+}
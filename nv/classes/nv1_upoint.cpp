@@ -0,0 +1,71 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_upoint.cpp: Single pixels
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1UPoint::Method(uint32_t offset, uint32_t param)
+    {
+        if (offset >= NV1_CLASS_METHOD(NV_UPOINT_POINT(0))
+        && offset < NV1_CLASS_METHOD(NV_UPOINT_POINT(NV_UPOINT_POINT__SIZE_1)))
+        {
+            Point((int16_t)(param & 0xFFFF), (int16_t)(param >> 16), color);
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_UPOINT_POINT32_0(0))
+        && offset < NV1_CLASS_METHOD(NV_UPOINT_POINT32_0(NV_UPOINT_POINT32_0__SIZE_1)))
+        {
+            // Y goes last
+            if (offset & 0x04)
+                Point(point_x, (int32_t)param, color);
+            else
+                point_x = (int32_t)param;
+
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_UPOINT_CPOINT_0(0))
+        && offset < NV1_CLASS_METHOD(NV_UPOINT_CPOINT_0(NV_UPOINT_CPOINT_0__SIZE_1)))
+        {
+            if (offset & 0x04)
+                Point((int16_t)(param & 0xFFFF), (int16_t)(param >> 16), cpoint_color);
+            else
+                cpoint_color = param;
+
+            return;
+        }
+
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UPOINT_COLOR):
+                color = param;
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+
+    // Same as lines, points are queued up until the batch is full or something else needs PGRAPH
+    void NV1UPoint::Point(int32_t x, int32_t y, uint32_t point_color)
+    {
+        if (batch_points == NV1_PGRAPH_POINT_BATCH_SIZE)
+            Flush();
+
+        batch[batch_points++] = { x, y, point_color };
+        gpu->pgraph.batch_object = this;
+    }
+
+    void NV1UPoint::Flush()
+    {
+        gpu->PGRAPHPoints(std::span(batch, batch_points));
+        batch_points = 0;
+    }
+}
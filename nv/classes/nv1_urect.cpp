@@ -0,0 +1,40 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_urect.cpp: Solid rectangles
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1URect::Method(uint32_t offset, uint32_t param)
+    {
+        // Up to 16 rectangles can be sent at once as position/size pairs. The size is always written last, so that's what draws it
+        if (offset >= NV1_CLASS_METHOD(NV_URECT_RECTANGLE_0(0))
+        && offset < NV1_CLASS_METHOD(NV_URECT_RECTANGLE_0(NV_URECT_RECTANGLE_0__SIZE_1)))
+        {
+            if (offset & 0x04)
+                gpu->PGRAPHFillRect(x, y, param & 0xFFFF, param >> 16, color);
+            else
+            {
+                x = (int16_t)(param & 0xFFFF);
+                y = (int16_t)(param >> 16);
+            }
+
+            return;
+        }
+
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_URECT_COLOR):
+                color = param;
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+}
@@ -0,0 +1,25 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_urop.cpp: Raster operation
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1URop::Method(uint32_t offset, uint32_t param)
+    {
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UROP_SET_ROP):
+                gpu->pgraph.rop3 = param & 0xFF;
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+}
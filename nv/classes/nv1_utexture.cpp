@@ -0,0 +1,96 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_utexture.cpp: Texture patches (NV_UBTM, NV_UQTM and their beta variants NV_UBTMB and NV_UQTMB)
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    // The bilinear and quadratic classes have the same methods at the same offsets, only with fewer control points
+    void NV1UTexture::Method(uint32_t offset, uint32_t param)
+    {
+        uint32_t points = (order + 1) * (order + 1);
+
+        // Changing the patch starts the texture again
+        if (offset >= NV1_CLASS_METHOD(NV_UQTM_POINT_OUT(0))
+        && offset < NV1_CLASS_METHOD(NV_UQTM_POINT_OUT(points)))
+        {
+            uint32_t point = (offset - NV1_CLASS_METHOD(NV_UQTM_POINT_OUT(0))) >> 2;
+
+            control_x[point] = (int16_t)(param & 0xFFFF) * 16;
+            control_y[point] = (int16_t)(param >> 16) * 16;
+            row = column = 0;
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_UQTM_POINT_OUT12D4(0))
+        && offset < NV1_CLASS_METHOD(NV_UQTM_POINT_OUT12D4(points)))
+        {
+            uint32_t point = (offset - NV1_CLASS_METHOD(NV_UQTM_POINT_OUT12D4(0))) >> 2;
+
+            control_x[point] = (int16_t)(param & 0xFFFF);
+            control_y[point] = (int16_t)(param >> 16);
+            row = column = 0;
+            return;
+        }
+
+        // Two 1.15 betas per method, in the same order as the control points. They're kept in NV_PGRAPH_BETA_RAM
+        if (blended
+        && offset >= NV1_CLASS_METHOD(NV_UQTMB_BETA(0))
+        && offset < NV1_CLASS_METHOD(NV_UQTMB_BETA((points + 1) / 2)))
+        {
+            uint32_t point = (offset - NV1_CLASS_METHOD(NV_UQTMB_BETA(0))) >> 1;
+
+            gpu->pgraph.beta_factor_ram[point] = param & 0xFFFF;
+            gpu->pgraph.beta_factor_ram[point + 1] = param >> 16;
+            row = column = 0;
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_UQTM_COLOR(0))
+        && offset < NV1_CLASS_METHOD(NV_UQTM_COLOR(NV_UQTM_COLOR__SIZE_1)))
+        {
+            Texel(param);
+            return;
+        }
+
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UQTM_SUBDIVIDE_IN):
+                gpu->pgraph.subdivide = param;
+                row = column = 0;
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+
+    // Once a row of the texture is all here, it's drawn. The whole texture being sent starts it again. The mesh is looked up
+    // for each row, because another patch could have pushed it out of the cache since the last one
+    void NV1UTexture::Texel(uint32_t param)
+    {
+        texels[column++] = param;
+
+        // the texture is 2^MINOR texels wide
+        if (column < (1u << std::min<uint32_t>((gpu->pgraph.subdivide >> 4) & 0x0F, NV_PGRAPH_SUBDIVIDE_BY_256)))
+            return;
+
+        int32_t control_beta[NV1_PGRAPH_PATCH_MAX_POINTS] = { };
+
+        for (uint32_t point = 0; point < NV1_PGRAPH_PATCH_MAX_POINTS && blended; point++)
+            control_beta[point] = (int16_t)gpu->pgraph.beta_factor_ram[point];
+
+        const auto& mesh = gpu->PGRAPHGetPatchMesh(order, control_x, control_y, (blended) ? control_beta : nullptr, gpu->pgraph.subdivide);
+
+        gpu->PGRAPHPatchRow(mesh, row, texels);
+        column = 0;
+
+        if (++row >= mesh.rows)
+            row = 0;
+    }
+}
@@ -0,0 +1,39 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_utomem.cpp: Images to memory
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1UToMem::Method(uint32_t offset, uint32_t param)
+    {
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UTOMEM_SET_NOTIFY):
+                notify = true;
+                break;
+            case NV1_CLASS_METHOD(NV_UTOMEM_POINT):
+                point = param;
+                break;
+            case NV1_CLASS_METHOD(NV_UTOMEM_SIZE):
+                size = param;
+                break;
+            case NV1_CLASS_METHOD(NV_UTOMEM_IMAGE_PITCH):
+                pitch = (int32_t)param;
+                break;
+            // DMA isn't there yet, so the start is an offset into the buffer the host gave PGRAPHSetReadbackBuffer
+            case NV1_CLASS_METHOD(NV_UTOMEM_IMAGE_START):
+                gpu->PGRAPHReadback((int16_t)(point & 0xFFFF), (int16_t)(point >> 16), size & 0xFFFF, size >> 16, param, pitch, notify);
+                notify = false;
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+}
@@ -0,0 +1,124 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_utri.cpp: Flat shaded triangles
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+namespace NV1Sim
+{
+    void NV1UTri::Method(uint32_t offset, uint32_t param)
+    {
+        // Meshes. Each vertex makes a triangle with the two before it
+        if (offset >= NV1_CLASS_METHOD(NV_UTRI_TRIMESH(0))
+        && offset < NV1_CLASS_METHOD(NV_UTRI_TRIMESH(NV_UTRI_TRIMESH__SIZE_1)))
+        {
+            MeshVertex((int16_t)(param & 0xFFFF), (int16_t)(param >> 16));
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_UTRI_TRIMESH32_0(0))
+        && offset < NV1_CLASS_METHOD(NV_UTRI_TRIMESH32_0(NV_UTRI_TRIMESH32_0__SIZE_1)))
+        {
+            // Y goes last
+            if (offset & 0x04)
+                MeshVertex(mesh_x, (int32_t)param);
+            else
+                mesh_x = (int32_t)param;
+
+            return;
+        }
+
+        // Triangles and meshes with their own colour
+        if (offset >= NV1_CLASS_METHOD(NV_UTRI_CTRIANGLE_0(0))
+        && offset < NV1_CLASS_METHOD(NV_UTRI_CTRIANGLE_0(NV_UTRI_CTRIANGLE_0__SIZE_1)))
+        {
+            uint32_t vertex = ((offset >> 2) & 0x03);
+
+            if (!vertex)
+                color = param;
+            else
+            {
+                x[vertex - 1] = (int16_t)(param & 0xFFFF);
+                y[vertex - 1] = (int16_t)(param >> 16);
+
+                if (vertex == 3)
+                    Draw();
+            }
+
+            return;
+        }
+
+        if (offset >= NV1_CLASS_METHOD(NV_UTRI_CTRIMESH_0(0))
+        && offset < NV1_CLASS_METHOD(NV_UTRI_CTRIMESH_0(NV_UTRI_CTRIMESH_0__SIZE_1)))
+        {
+            if (offset & 0x04)
+                MeshVertex((int16_t)(param & 0xFFFF), (int16_t)(param >> 16));
+            else
+                color = param;
+
+            return;
+        }
+
+        switch (offset)
+        {
+            case NV1_CLASS_METHOD(NV_UTRI_COLOR):
+                color = param;
+                break;
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE_0):
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE_1):
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE_2):
+            {
+                uint32_t vertex = (offset - NV1_CLASS_METHOD(NV_UTRI_TRIANGLE_0)) >> 2;
+
+                x[vertex] = (int16_t)(param & 0xFFFF);
+                y[vertex] = (int16_t)(param >> 16);
+
+                if (vertex == 2)
+                    Draw();
+
+                break;
+            }
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_0):
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_2):
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_4):
+                x[(offset - NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_0)) >> 3] = (int32_t)param;
+                break;
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_1):
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_3):
+                y[(offset - NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_0)) >> 3] = (int32_t)param;
+                break;
+            case NV1_CLASS_METHOD(NV_UTRI_TRIANGLE32_5):
+                y[2] = (int32_t)param;
+                Draw();
+                break;
+            default:
+                NV1UBase::Method(offset, param);
+                break;
+        }
+    }
+
+    // A whole triangle also starts a mesh that later mesh vertices carry on from
+    void NV1UTri::Draw()
+    {
+        gpu->PGRAPHTriangle(x, y, color);
+        mesh_vertices = 3;
+    }
+
+    void NV1UTri::MeshVertex(int32_t vertex_x, int32_t vertex_y)
+    {
+        std::rotate(std::begin(x), std::begin(x) + 1, std::end(x));
+        std::rotate(std::begin(y), std::begin(y) + 1, std::end(y));
+        x[2] = vertex_x;
+        y[2] = vertex_y;
+
+        if (mesh_vertices < 3)
+            mesh_vertices++;
+
+        if (mesh_vertices == 3)
+            gpu->PGRAPHTriangle(x, y, color);
+    }
+}
@@ -33,12 +33,114 @@ namespace NV1Sim
         WriteRegister32(NV_PEXTDEV_BOOT_0, (NV_PEXTDEV_BOOT_0_STRAP_BOARD_ADAPTER_1 << NV_PEXTDEV_BOOT_0_STRAP_BOARD)
         | (NV_PEXTDEV_BOOT_0_STRAP_VENDOR_NVIDIA << NV_PEXTDEV_BOOT_0_STRAP_VENDOR));
         // rest don't really matter, and these don't really matter but w/e
-        
+
+        // RAMRO has to be somewhere before anything can run out into it
+        WriteRegister32(NV_PRAM_CONFIG_0, 0);
+        pfifo.cache1.cache_data.status = 0;
+
+        PGRAPHInit();
+    }
+
+    void NV1::Start()
+    {
+        state.running = true;
+
+        if (settings.pfifo_thread
+        && !state.puller_thread.joinable())
+        {
+            state.puller_running = true;
+            state.puller_asleep = false;
+            state.puller_thread = std::thread(&NV1::PFIFOPullerThread, this);
+
+            Logging_LogChannel("PFIFO puller running on its own thread", LogChannel::Message);
+        }
+    }
+
+    void NV1::Stop()
+    {
+        state.running = false;
+
+        if (state.puller_thread.joinable())
+        {
+            state.puller_running = false;
+            PFIFOWakePuller();
+            state.puller_thread.join();
+        }
+
+        if (state.readback_thread.joinable())
+        {
+            PGRAPHWaitForReadback();
+            state.readback_running = false;
+            PGRAPHWakeReadback();
+            state.readback_thread.join();
+        }
+    }
+
+    // Write a stream of (address, value) pairs
+    void NV1::WriteRegisters32(std::span<const std::pair<uint32_t, uint32_t>> writes)
+    {
+        size_t write_number = 0;
+
+        while (write_number < writes.size())
+        {
+            uint32_t addr = writes[write_number].first;
+
+            // same as WriteRegister32
+            if (addr < NV_USER_START)
+                PFIFOWaitForPuller();
+
+            if (addr < NV1_PRAMIN_START)
+            {
+                // Registers: look the page up once for the whole run of writes inside it
+                uint32_t page_base = addr & ~NV1_MMIO_PAGE_MASK;
+                uint16_t page = nv1_mmio_decoder.pages[addr >> NV1_MMIO_PAGE_SHIFT];
+
+                do
+                {
+                    addr = writes[write_number].first;
+                    uint32_t value = writes[write_number].second;
+
+                    const NV1MMIOSlot* slot = (page) ? &nv1_mmio_decoder.slots[page - 1][(addr & NV1_MMIO_PAGE_MASK) >> 2] : nullptr;
+
+                    if (slot 
+                    && slot->mapping)
+                        MMIOWrite(&nv1_mappings32[slot->mapping - 1], slot->index, value);
+                    else
+                        Logging_LogChannel("Write of 0x%08x to unmapped MMIO address 0x%08x", LogChannel::Debug, value, addr);
+
+                    write_number++;
+                } while (write_number < writes.size()
+                && (writes[write_number].first & ~NV1_MMIO_PAGE_MASK) == page_base);
+            }
+            else if (addr < NV_USER_START)
+            {
+                WriteRAMIN32(addr - NV1_PRAMIN_START, writes[write_number].second);
+                write_number++;
+            }
+            else
+            {
+                // Channel methods: the channel is the same for the whole run of writes to one subchannel, so the run goes into CACHE1 in one go
+                uint32_t subchannel_base = addr & ~NV1_USER_SUBCHANNEL_MASK;
+                size_t run_start = write_number;
+
+                do
+                {
+                    write_number++;
+                } while (write_number < writes.size()
+                && (writes[write_number].first & ~NV1_USER_SUBCHANNEL_MASK) == subchannel_base);
+
+                PFIFOCache1PushRun(NV1_USER_CHANNEL(addr), writes.subspan(run_start, write_number - run_start));
+            }
+        }
     }
 
     // Sets the interrupt state of the NV1
     void NV1::FirePendingInterrupts()
     {
+        // notifies from the readback thread
+        if (state.readback_notify.exchange(false, std::memory_order_acquire))
+            pgraph.intr_0 |= (NV_PGRAPH_INTR_0_NOTIFY_PENDING << 28);
+
         // interrupts disabled entirely
         if (!pmc.intr_en)
             return; 
@@ -46,44 +148,38 @@ namespace NV1Sim
         // I don't think we need to implement pDMA interrupts
 
         if (paudio.intr & paudio.intr_en)
-            pmc.intr |= (1 >> NV_PMC_INTR_0_PAUDIO);
+            pmc.intr |= (1 << NV_PMC_INTR_0_PAUDIO);
         else
-            pmc.intr &= ~(1 >> NV_PMC_INTR_0_PAUDIO);
+            pmc.intr &= ~(1 << NV_PMC_INTR_0_PAUDIO);
 
         if (prm.intr & prm.intr_en)
-            pmc.intr |= (1 >> NV_PMC_INTR_0_PRM);
+            pmc.intr |= (1 << NV_PMC_INTR_0_PRM);
         else
-            pmc.intr &= ~(1 >> NV_PMC_INTR_0_PRM);
+            pmc.intr &= ~(1 << NV_PMC_INTR_0_PRM);
 
         if (pfifo.intr & pfifo.intr_en)
-            pmc.intr |= (1 >> NV_PMC_INTR_0_PFIFO);
+            pmc.intr |= (1 << NV_PMC_INTR_0_PFIFO);
         else
-            pmc.intr &= ~(1 >> NV_PMC_INTR_0_PFIFO);
+            pmc.intr &= ~(1 << NV_PMC_INTR_0_PFIFO);
 
         // I don't think we need to test PMC
         // PFB is subset of PGRAPH (used for BLANK) since pfb_intr_en doens't exist
-        if (pgraph.intr_0 & (1 << 8) 
-        && pgraph.intr_en_0 & (1 << 8))
-            pmc.intr |= (1 >> NV_PMC_INTR_0_PFB);
-        else
-            pmc.intr &= ~(1 >> NV_PMC_INTR_0_PFB);
-
-        if (pgraph.intr_0  & ~(1 << 8) 
-        && pgraph.intr_en_0 & ~(1 << 8))
-            pmc.intr |= (1 >> NV_PMC_INTR_0_PGRAPH);
+        if (pgraph.intr_0 & pgraph.intr_en_0 & (1 << 8))
+            pmc.intr |= (1 << NV_PMC_INTR_0_PFB);
         else
-            pmc.intr &= ~(1 >> NV_PMC_INTR_0_PGRAPH);
+            pmc.intr &= ~(1 << NV_PMC_INTR_0_PFB);
 
         // pgraph has 2
-        if (pgraph.intr_1 & pgraph.intr_en_1)
-            pmc.intr |= (1 >> NV_PMC_INTR_0_PGRAPH);
+        if ((pgraph.intr_0 & pgraph.intr_en_0 & ~(1 << 8))
+        || (pgraph.intr_1 & pgraph.intr_en_1))
+            pmc.intr |= (1 << NV_PMC_INTR_0_PGRAPH);
         else
-            pmc.intr &= ~(1 >> NV_PMC_INTR_0_PGRAPH);
+            pmc.intr &= ~(1 << NV_PMC_INTR_0_PGRAPH);
 
         if (ptimer.intr & ptimer.intr_en)
-            pmc.intr |= (1 >> NV_PMC_INTR_0_PTIMER);
+            pmc.intr |= (1 << NV_PMC_INTR_0_PTIMER);
         else
-            pmc.intr &= ~(1 >> NV_PMC_INTR_0_PTIMER);
+            pmc.intr &= ~(1 << NV_PMC_INTR_0_PTIMER);
         
         // Software interrupts
         if (pmc.intr & NV_PMC_INTR_0_SOFTWARE) 
@@ -93,6 +189,18 @@ namespace NV1Sim
         }
     }
 
+    uint32_t NV1::ReadPendingInterrupts()
+    {
+        FirePendingInterrupts();
+        return pmc.intr;
+    }
+
+    uint32_t NV1::PGRAPHReadIntr0()
+    {
+        FirePendingInterrupts();
+        return pgraph.intr_0;
+    }
+
     // Set NV1 RAMIN Config
     void NV1::SetRAMINConfig(uint32_t value)
     {
@@ -114,6 +222,13 @@ namespace NV1Sim
         pram.ramau_start = pram.ramfc_start + pram.ramfc_size;
         pram.rampw_start = pram.ramau_start + pram.rampw_size;
 
+        // RAMHT has moved
+        RAMHTInvalidate();
+
+        // and so has RAMFC, so every channel context we have needs to be written out again
+        for (PFIFOChannelContext& context : pfifo.channel_contexts)
+            context.dirty = context.valid;
+
     }
 
 }
\ No newline at end of file
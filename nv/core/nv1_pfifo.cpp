@@ -13,18 +13,494 @@ namespace NV1Sim
         
     }
     
-    void NV1::PFIFOCache1Push()
+    // Push a method written to USER space into CACHE1. This is the producer side of the ring.
+    // method is the subchannel and method offset, in the same format as NV_PFIFO_CACHE1_METHOD
+    void NV1::PFIFOCache1Push(uint32_t channel, uint32_t method, uint32_t param)
     {
+        // another channel wants CACHE1
+        if (channel != pfifo.cache1.cache_data.push_channel_id)
+        {
+            if (!(pfifo.cache_reassignment & NV_PFIFO_CACHES_REASSIGN_ENABLED))
+            {
+                PFIFORunout(channel, method, param, NV_RAMRO_REASON_NO_CACHE_AVAILABLE);
+                return;
+            }
 
+            PFIFOSwitchChannel(channel);
+        }
+
+        // once something has gone to RAMRO, everything after it has to as well, or the methods would be run out of order
+        if (pfifo.cache1.cache_data.status & NV_PFIFO_CACHE1_STATUS_RANOUT_TRUE)
+        {
+            PFIFORunout(channel, method, param, NV_RAMRO_REASON_CACHE_RAN_OUT);
+            return;
+        }
+
+        uint32_t put_address = pfifo.cache1.put_address.load(std::memory_order_relaxed);
+        uint32_t next_put_address = (put_address + 1) & NV1_CACHE1_MASK;
+
+        // without a puller thread, make room by running the puller ourselves
+        if (next_put_address == pfifo.cache1.get_address.load(std::memory_order_acquire)
+        && !settings.pfifo_thread)
+            PFIFOUpdate();
+
+        // the client wrote more than the free count said it could
+        if (next_put_address == pfifo.cache1.get_address.load(std::memory_order_acquire))
+        {
+            PFIFORunout(channel, method, param, NV_RAMRO_REASON_FREE_COUNT_OVERRUN);
+            return;
+        }
+
+        pfifo.cache1_data[put_address].method = method;
+        pfifo.cache1_data[put_address].param = param;
+
+        // publish the entry to the puller. seq_cst so that it can't pass our check of puller_asleep (see PFIFOPullerThread)
+        pfifo.cache1.put_address.store(next_put_address, std::memory_order_seq_cst);
+
+        if (state.puller_asleep.load(std::memory_order_seq_cst))
+            PFIFOWakePuller();
     }
     
+    // Push a run of methods written to one channel's USER space. The channel and RANOUT are only checked once, and the run is
+    // copied in as many pieces as CACHE1 has room for, each published with one update of PUT. When CACHE1 is full, the run
+    // waits for the puller (or runs the puller itself if there is no thread) rather than running out, so a run can be any length
+    void NV1::PFIFOCache1PushRun(uint32_t channel, std::span<const std::pair<uint32_t, uint32_t>> writes)
+    {
+        bool switch_allowed = pfifo.cache_reassignment & NV_PFIFO_CACHES_REASSIGN_ENABLED;
+
+        if (channel != pfifo.cache1.cache_data.push_channel_id
+        && switch_allowed)
+            PFIFOSwitchChannel(channel);
+
+        // a run that can't go into CACHE1 at all is run out a method at a time
+        if (channel != pfifo.cache1.cache_data.push_channel_id
+        || (pfifo.cache1.cache_data.status & NV_PFIFO_CACHE1_STATUS_RANOUT_TRUE))
+        {
+            for (const std::pair<uint32_t, uint32_t>& write : writes)
+                PFIFOCache1Push(channel, NV1_USER_METHOD(write.first), write.second);
+
+            return;
+        }
+
+        while (!writes.empty())
+        {
+            uint32_t put_address = pfifo.cache1.put_address.load(std::memory_order_relaxed);
+            uint32_t free = (pfifo.cache1.get_address.load(std::memory_order_acquire) - put_address - 1) & NV1_CACHE1_MASK;
+
+            if (!free)
+            {
+                if (state.puller_running.load(std::memory_order_acquire))
+                    PFIFOWaitForFree();
+                else
+                    PFIFOUpdate();
+
+                continue;
+            }
+
+            size_t count = std::min<size_t>(writes.size(), free);
+
+            for (size_t write = 0; write < count; write++, put_address = (put_address + 1) & NV1_CACHE1_MASK)
+            {
+                pfifo.cache1_data[put_address].method = NV1_USER_METHOD(writes[write].first);
+                pfifo.cache1_data[put_address].param = writes[write].second;
+            }
+
+            // same as PFIFOCache1Push
+            pfifo.cache1.put_address.store(put_address, std::memory_order_seq_cst);
+
+            if (state.puller_asleep.load(std::memory_order_seq_cst))
+                PFIFOWakePuller();
+
+            writes = writes.subspan(count);
+        }
+    }
+
+    // Wait until the puller thread has taken something out of a full CACHE1. seq_cst on both sides, the same as puller_asleep,
+    // so that either we see GET move or the puller sees us waiting
+    void NV1::PFIFOWaitForFree()
+    {
+        uint32_t get_address;
+
+        state.pusher_waiting.store(true, std::memory_order_seq_cst);
+
+        while ((((get_address = pfifo.cache1.get_address.load(std::memory_order_seq_cst)) - pfifo.cache1.put_address.load(std::memory_order_relaxed) - 1) & NV1_CACHE1_MASK) == 0)
+            pfifo.cache1.get_address.wait(get_address, std::memory_order_acquire);
+
+        state.pusher_waiting.store(false, std::memory_order_relaxed);
+    }
+
     void NV1::PFIFOCache0Pull()
     {
 
     }
     
-    void NV1::PFIFOCache1Pull()
+    // Take the oldest method out of CACHE1. This is the consumer side of the ring. Returns false if CACHE1 is empty
+    bool NV1::PFIFOCache1Pull(PFIFOCacheEntry& entry)
     {
+        uint32_t get_address = pfifo.cache1.get_address.load(std::memory_order_relaxed);
+
+        if (get_address == pfifo.cache1.put_address.load(std::memory_order_acquire))
+            return false; 
+
+        entry = pfifo.cache1_data[get_address];
+
+        // hand the slot back to the pusher, which might be waiting for it (see PFIFOWaitForFree)
+        pfifo.cache1.get_address.store((get_address + 1) & NV1_CACHE1_MASK, std::memory_order_seq_cst);
+
+        if (state.pusher_waiting.load(std::memory_order_seq_cst))
+            pfifo.cache1.get_address.notify_all();
+
+        return true; 
+    }
+
+    // Run the puller until CACHE1 is empty
+    void NV1::PFIFOUpdate()
+    {
+        PFIFOCacheEntry entry;
+
+        while (PFIFOCache1Pull(entry))
+        {
+            // Method 0 of every subchannel binds an object to it
+            if ((entry.method & NV1_USER_SUBCHANNEL_MASK) == 0)
+                PFIFOSetObject(pfifo.cache1.cache_data.push_channel_id, entry.method >> 13, entry.param);
+            else
+                PGRAPHMethod(entry.method, entry.param);
+        }
 
+        // CACHE1 is empty, so nothing else is going to join a batch
+        PGRAPHFlush();
+    }
+
+    // Give CACHE1 to another channel. The outgoing channel's state is kept in PFIFO::channel_contexts, so switching back to a channel
+    // that has been seen before doesn't need RAMFC at all
+    void NV1::PFIFOSwitchChannel(uint32_t channel)
+    {
+        PFIFOCacheBase& cache = pfifo.cache1.cache_data;
+
+        // the puller must be done with the outgoing channel's methods before its state can be moved
+        PFIFOWaitForPuller();
+
+        PFIFOChannelContext& old_context = pfifo.channel_contexts[cache.push_channel_id & NV1_CHANNEL_MASK];
+        PFIFOChannelContext& new_context = pfifo.channel_contexts[channel & NV1_CHANNEL_MASK];
+
+        std::copy(std::begin(cache.context), std::end(cache.context), old_context.context);
+        old_context.pull1 = cache.pull1;
+        old_context.valid = true;
+        old_context.dirty = true;
+
+        if (!new_context.valid)
+            PFIFOLoadChannelContext(channel);
+
+        std::copy(std::begin(new_context.context), std::end(new_context.context), cache.context);
+        cache.pull1 = new_context.pull1;
+        cache.push_channel_id = channel;
+    }
+
+    // Bring a channel's saved state in from RAMFC
+    void NV1::PFIFOLoadChannelContext(uint32_t channel)
+    {
+        PFIFOChannelContext& context = pfifo.channel_contexts[channel & NV1_CHANNEL_MASK];
+        uint32_t ramfc_addr = pram.ramfc_start + channel * NV1_RAMFC_ENTRY_SIZE;
+
+        context = { };
+        context.valid = true;
+
+        // this RAMIN config doesn't have room for this channel
+        if (channel * NV1_RAMFC_ENTRY_SIZE >= pram.ramfc_size)
+            return;
+
+        for (uint32_t subchannel = 0; subchannel < NV_PFIFO_CACHE1_CTX__SIZE_1; subchannel++)
+            context.context[subchannel] = ReadRAMIN32(ramfc_addr + subchannel * 4) & 0x1FFFFFF;   // instance, device and lie
+
+        // the first entry also has the current subchannel (bits 30:28) and whether the object changed (bit 31)
+        uint32_t ramfc_0 = ReadRAMIN32(ramfc_addr);
+        context.pull1 = (((ramfc_0 >> 31) & 0x01) << 8) | ((ramfc_0 >> 28) & 0x07);
+    }
+
+    // Write a channel's saved state back to RAMFC, if it has changed since it was last there
+    void NV1::PFIFOStoreChannelContext(uint32_t channel)
+    {
+        if (channel >= NV1_CHANNELS)
+            return;
+
+        PFIFOChannelContext& context = pfifo.channel_contexts[channel];
+
+        if (!context.valid
+        || !context.dirty
+        || channel * NV1_RAMFC_ENTRY_SIZE >= pram.ramfc_size)
+            return;
+
+        uint32_t ramfc_addr = pram.ramfc_start + channel * NV1_RAMFC_ENTRY_SIZE;
+
+        // not WriteRAMIN32, that would throw this context away
+        for (uint32_t subchannel = 0; subchannel < NV_PFIFO_CACHE1_CTX__SIZE_1; subchannel++)
+            state.video_ram32[GetRAMINAddress(ramfc_addr + subchannel * 4) >> 2] = context.context[subchannel];
+
+        state.video_ram32[GetRAMINAddress(ramfc_addr) >> 2] |= (((context.pull1 >> 8) & 0x01) << 31) | ((context.pull1 & 0x07) << 28);
+
+        context.dirty = false;
+    }
+
+    // RAMFC is being written for a channel, so whatever it has there is the state from now on
+    void NV1::PFIFODiscardChannelContext(uint32_t channel)
+    {
+        if (channel >= NV1_CHANNELS)
+            return;
+
+        PFIFOStoreChannelContext(channel);
+        pfifo.channel_contexts[channel].valid = false;
+    }
+
+    // Put a method that CACHE1 couldn't take into RAMRO, for the resource manager to deal with
+    void NV1::PFIFORunout(uint32_t channel, uint32_t method, uint32_t param, uint32_t reason)
+    {
+        uint32_t ramro_mask = pram.ramro_size - 1;
+        uint32_t put_address = pfifo.runout_put_address & ramro_mask;
+        uint32_t next_put_address = (put_address + NV1_RAMRO_ENTRY_SIZE) & ramro_mask;
+
+        if (next_put_address == (pfifo.runout_get_address & ramro_mask))
+        {
+            pfifo.runout_overflows.store(pfifo.runout_overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            pfifo.intr |= (NV_PFIFO_INTR_0_RUNOUT_OVERFLOW_PENDING << 8);
+            Logging_LogChannel("RAMRO full, dropped method 0x%04x (channel %d)", LogChannel::Debug, method, channel);
+            return;
+        }
+
+        // bit26 - 16-bit access (never, USER writes are all 32-bit); bit27 - read
+        WriteRAMIN32(pram.ramro_start + put_address, (reason << 28) | ((channel & NV1_CHANNEL_MASK) << 16) | (method & 0xFFFF));
+        WriteRAMIN32(pram.ramro_start + put_address + 4, param);
+
+        pfifo.runout_put_address = next_put_address;
+        pfifo.runout_entries.store(pfifo.runout_entries.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        pfifo.cache1.cache_data.status |= NV_PFIFO_CACHE1_STATUS_RANOUT_TRUE;
+        pfifo.intr |= (NV_PFIFO_INTR_0_RUNOUT_PENDING << 4);
+    }
+
+    // Take as many entries out of RAMRO as will fit, moving GET once at the end rather than per entry. 
+    // Returns how many were read
+    uint32_t NV1::PFIFOReadRunout(std::span<PFIFORunoutEntry> entries)
+    {
+        uint32_t ramro_mask = pram.ramro_size - 1;
+        uint32_t get_address = pfifo.runout_get_address & ramro_mask;
+        uint32_t put_address = pfifo.runout_put_address & ramro_mask;
+        uint32_t count = 0;
+
+        while (get_address != put_address
+        && count < entries.size())
+        {
+            uint32_t ramro_0 = ReadRAMIN32(pram.ramro_start + get_address);
+            PFIFORunoutEntry& entry = entries[count++];
+
+            entry.method = ramro_0 & 0xFFFF;
+            entry.channel = (ramro_0 >> 16) & 0x7F;
+            entry.reason = (ramro_0 >> 28) & 0x0F;
+            entry.param = ReadRAMIN32(pram.ramro_start + get_address + 4);
+
+            get_address = (get_address + NV1_RAMRO_ENTRY_SIZE) & ramro_mask;
+        }
+
+        pfifo.runout_get_address = get_address;
+
+        // all caught up, so CACHE1 can be used again
+        if (get_address == put_address)
+        {
+            pfifo.cache1.cache_data.status &= ~NV_PFIFO_CACHE1_STATUS_RANOUT_TRUE;
+            pfifo.intr &= ~(NV_PFIFO_INTR_0_RUNOUT_PENDING << 4);
+        }
+
+        return count;
+    }
+
+    // Bind the object with the given handle to a subchannel
+    void NV1::PFIFOSetObject(uint32_t channel, uint32_t subchannel, uint32_t handle)
+    {
+        PFIFOCacheBase& cache = pfifo.cache1.cache_data;
+        uint32_t context = 0;
+
+        if (!RAMHTLookup(handle, channel, context))
+        {
+            cache.pull0 |= (NV_PFIFO_CACHE1_PULL0_HASH_FAILED << 4);
+            Logging_LogChannel("RAMHT lookup failed for handle 0x%08x (channel %d)", LogChannel::Debug, handle, channel);
+            return;
+        }
+
+        cache.pull0 &= ~(NV_PFIFO_CACHE1_PULL0_HASH_FAILED << 4);
+        cache.context[subchannel] = context & 0x7FFFFF; // instance and device
+        cache.pull1 = (NV_PFIFO_CACHE1_PULL1_OBJECT_CHANGED << 8) | subchannel;
+    }
+
+    // RAMHT hash. XOR-folds the handle down to the width of the table index, then mixes in the channel
+    uint32_t NV1::RAMHTHash(uint32_t handle, uint32_t channel)
+    {
+        uint32_t num_bits = 9 + pram.config;        // 512 entries at the smallest RAMHT size
+        uint32_t mask = (1 << num_bits) - 1;
+        uint32_t hash = 0;
+
+        while (handle)
+        {
+            hash ^= handle & mask;
+            handle >>= num_bits;
+        }
+
+        return (hash ^ (channel << (num_bits - 7))) & mask;
+    }
+
+    // Find an object in RAMHT, going through the lookup cache first.
+    // On success context is the second dword of the RAMHT entry
+    bool NV1::RAMHTLookup(uint32_t handle, uint32_t channel, uint32_t& context)
+    {
+        RAMHTCache& cache = pfifo.ramht_cache;
+        uint32_t generation = cache.generation.load(std::memory_order_acquire);
+        RAMHTCacheEntry& cache_entry = cache.entries[(handle ^ (handle >> 8) ^ (channel << 1)) & (NV1_RAMHT_CACHE_SIZE - 1)];
+
+        if (cache_entry.generation == generation
+        && cache_entry.handle == handle
+        && cache_entry.channel == channel)
+        {
+            cache.hits.store(cache.hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            context = cache_entry.context;
+            return true;
+        }
+
+        cache.misses.store(cache.misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        // Walk RAMHT from where the hash says the object should be
+        uint32_t num_entries = pram.ramht_size / NV1_RAMHT_ENTRY_SIZE;
+        uint32_t entry_number = RAMHTHash(handle, channel);
+
+        for (uint32_t probe = 0; probe < num_entries; probe++)
+        {
+            uint32_t entry_addr = pram.ramht_start + entry_number * NV1_RAMHT_ENTRY_SIZE;
+            uint32_t entry_handle = ReadRAMIN32(entry_addr);
+            uint32_t entry_context = ReadRAMIN32(entry_addr + 4);
+
+            // empty slot, it isn't there
+            if (!entry_handle
+            && !entry_context)
+                return false;
+
+            if (entry_handle == handle
+            && ((entry_context >> 24) & 0x7F) == channel)
+            {
+                // tag it with the generation from before the walk, so a RAMHT write during the walk still invalidates it
+                cache_entry.handle = handle;
+                cache_entry.channel = channel;
+                cache_entry.context = entry_context;
+                cache_entry.generation = generation;
+
+                context = entry_context;
+                return true;
+            }
+
+            entry_number = (entry_number + 1) % num_entries;
+        }
+
+        return false;
+    }
+
+    void NV1::RAMHTInvalidate()
+    {
+        pfifo.ramht_cache.generation.fetch_add(1, std::memory_order_release);
+    }
+
+    // The puller thread. Drains CACHE1 into PGRAPH as methods arrive and sleeps while it is empty. 
+    // The pusher is throttled the same way as on hardware, by CACHE1 free count
+    void NV1::PFIFOPullerThread()
+    {
+        while (state.puller_running.load(std::memory_order_acquire))
+        {
+            PFIFOUpdate();
+
+            state.puller_asleep.store(true, std::memory_order_seq_cst);
+            state.puller_asleep.notify_all(); // for PFIFOWaitForPuller
+
+            // a method might have been pushed between draining and going to sleep, and the pusher might not have seen us asleep
+            if (pfifo.cache1.get_address.load(std::memory_order_relaxed) != pfifo.cache1.put_address.load(std::memory_order_seq_cst))
+            {
+                state.puller_asleep.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            state.puller_asleep.wait(true, std::memory_order_acquire);
+        }
+    }
+
+    void NV1::PFIFOWakePuller()
+    {
+        state.puller_asleep.store(false, std::memory_order_release);
+        state.puller_asleep.notify_all();
+    }
+
+    // Wait until the puller has run everything in CACHE1 and gone to sleep, along with any readbacks it started. For the pushing
+    // thread only, before it touches PGRAPH or VRAM itself. Nothing else pushes while it waits, so the puller can only be asleep
+    // with CACHE1 non-empty until it rechecks
+    void NV1::PFIFOWaitForPuller()
+    {
+        if (state.puller_running.load(std::memory_order_acquire))
+        {
+            while (!state.puller_asleep.load(std::memory_order_acquire)
+            || pfifo.cache1.get_address.load(std::memory_order_acquire) != pfifo.cache1.put_address.load(std::memory_order_relaxed))
+                state.puller_asleep.wait(false, std::memory_order_acquire);
+        }
+        else
+            PFIFOUpdate();
+
+        PGRAPHWaitForReadback();
+    }
+
+    // CACHE1 status is derived from GET and PUT rather than stored
+    uint32_t NV1::PFIFOReadCache1Status()
+    {
+        uint32_t get_address = pfifo.cache1.get_address.load(std::memory_order_acquire);
+        uint32_t put_address = pfifo.cache1.put_address.load(std::memory_order_acquire);
+        uint32_t status = pfifo.cache1.cache_data.status & (1 << 0); // ranout is the only stored bit
+
+        if (get_address == put_address)
+            status |= (NV_PFIFO_CACHE1_STATUS_LOW_MARK_EMPTY << 4);
+
+        if (((put_address + 1) & NV1_CACHE1_MASK) == get_address)
+            status |= (NV_PFIFO_CACHE1_STATUS_HIGH_MARK_FULL << 8);
+
+        return status;
+    }
+
+    // Runout status is derived from GET and PUT as well
+    uint32_t NV1::PFIFOReadRunoutStatus()
+    {
+        uint32_t ramro_mask = pram.ramro_size - 1;
+        uint32_t get_address = pfifo.runout_get_address & ramro_mask;
+        uint32_t put_address = pfifo.runout_put_address & ramro_mask;
+        uint32_t status = 0;
+
+        if (get_address == put_address)
+            status |= (NV_PFIFO_RUNOUT_STATUS_LOW_MARK_EMPTY << 4);
+        else
+            status |= NV_PFIFO_RUNOUT_STATUS_RANOUT_TRUE;
+
+        if (((put_address + NV1_RAMRO_ENTRY_SIZE) & ramro_mask) == get_address)
+            status |= (NV_PFIFO_RUNOUT_STATUS_HIGH_MARK_FULL << 8);
+
+        return status;
+    }
+
+    // GET and PUT are gray coded (in bits 6:2) when accessed over MMIO
+    uint32_t NV1::PFIFOReadCache1Get()
+    {
+        return Util_Binary2Gray(pfifo.cache1.get_address.load(std::memory_order_relaxed)) << 2;
+    }
+
+    void NV1::PFIFOWriteCache1Get(uint32_t value)
+    {
+        pfifo.cache1.get_address.store(Util_Gray2Binary((value >> 2) & NV1_CACHE1_MASK), std::memory_order_release);
+    }
+
+    uint32_t NV1::PFIFOReadCache1Put()
+    {
+        return Util_Binary2Gray(pfifo.cache1.put_address.load(std::memory_order_relaxed)) << 2;
+    }
+
+    void NV1::PFIFOWriteCache1Put(uint32_t value)
+    {
+        pfifo.cache1.put_address.store(Util_Gray2Binary((value >> 2) & NV1_CACHE1_MASK), std::memory_order_release);
     }
 }
\ No newline at end of file
@@ -0,0 +1,698 @@
+//
+// nv1_pgraph.cpp
+// NV1 2D & 3D Graphics Engine
+//
+
+#include <nv/nv1.hpp>
+#include <nv/nv1_class.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define NV1_PGRAPH_SIMD
+#endif
+
+namespace NV1Sim
+{
+    // Width of the framebuffer for each NV_PFB_CONFIG_0_RESOLUTION
+    static constexpr uint32_t nv1_pfb_resolution_width[] = { 576, 640, 800, 1024, 1152, 1280, 1600, 1600 };
+
+    // Span fills. pattern is one 32-bit word of pixels and repeats every 4 bytes from the start of VRAM,
+    // so any byte of the span is just the byte of pattern at the same position within a dword
+    static void PGRAPHFillSpanScalar(uint8_t* dst, uint32_t bytes, uint32_t pattern)
+    {
+        for (; bytes; bytes--, dst++)
+            *dst = pattern >> (((uintptr_t)dst & 0x03) << 3);
+    }
+
+#ifdef NV1_PGRAPH_SIMD
+    static void PGRAPHFillSpanSSE2(uint8_t* dst, uint32_t bytes, uint32_t pattern)
+    {
+        // scalar until the span is aligned, then whole vectors, then scalar for what's left
+        uint32_t head = std::min<uint32_t>((16 - ((uintptr_t)dst & 15)) & 15, bytes);
+
+        PGRAPHFillSpanScalar(dst, head, pattern);
+        dst += head;
+        bytes -= head;
+
+        __m128i value = _mm_set1_epi32(pattern);
+
+        for (; bytes >= 16; bytes -= 16, dst += 16)
+            _mm_store_si128((__m128i*)dst, value);
+
+        PGRAPHFillSpanScalar(dst, bytes, pattern);
+    }
+
+    __attribute__((target("avx2"))) static void PGRAPHFillSpanAVX2(uint8_t* dst, uint32_t bytes, uint32_t pattern)
+    {
+        uint32_t head = std::min<uint32_t>((32 - ((uintptr_t)dst & 31)) & 31, bytes);
+
+        PGRAPHFillSpanScalar(dst, head, pattern);
+        dst += head;
+        bytes -= head;
+
+        __m256i value = _mm256_set1_epi32(pattern);
+
+        for (; bytes >= 64; bytes -= 64, dst += 64)
+        {
+            _mm256_store_si256((__m256i*)dst, value);
+            _mm256_store_si256((__m256i*)(dst + 32), value);
+        }
+
+        if (bytes >= 32)
+        {
+            _mm256_store_si256((__m256i*)dst, value);
+            dst += 32;
+            bytes -= 32;
+        }
+
+        PGRAPHFillSpanScalar(dst, bytes, pattern);
+    }
+#endif
+
+    // Pick the fastest span fill the host can run
+    NV1::PGRAPHFillSpanFn NV1::PGRAPHGetFillSpan()
+    {
+#ifdef NV1_PGRAPH_SIMD
+        static const bool has_avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+
+        return (has_avx2) ? PGRAPHFillSpanAVX2 : PGRAPHFillSpanSSE2;
+#else
+        return PGRAPHFillSpanScalar;
+#endif
+    }
+
+    // Create the graphics classes
+    void NV1::PGRAPHInit()
+    {
+        pgraph.classes[NV1_CLASS_ID(NV_UBETA_CTX_SWITCH)] = new NV1UBeta(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UROP_CTX_SWITCH)] = new NV1URop(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UCLIP_CTX_SWITCH)] = new NV1UClip(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UPATT_CTX_SWITCH)] = new NV1UPatt(this);
+        pgraph.classes[NV1_CLASS_ID(NV_URECT_CTX_SWITCH)] = new NV1URect(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UPOINT_CTX_SWITCH)] = new NV1UPoint(this);
+        pgraph.classes[NV1_CLASS_ID(NV_ULINE_CTX_SWITCH)] = new NV1ULine(this, true);
+        pgraph.classes[NV1_CLASS_ID(NV_ULIN_CTX_SWITCH)] = new NV1ULine(this, false);
+        pgraph.classes[NV1_CLASS_ID(NV_UTRI_CTX_SWITCH)] = new NV1UTri(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UBTM_CTX_SWITCH)] = new NV1UTexture(this, 1, false);
+        pgraph.classes[NV1_CLASS_ID(NV_UQTM_CTX_SWITCH)] = new NV1UTexture(this, 2, false);
+        pgraph.classes[NV1_CLASS_ID(NV_UBLIT_CTX_SWITCH)] = new NV1UBlit(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UIMAGE_CTX_SWITCH)] = new NV1UImage(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UBITMAP_CTX_SWITCH)] = new NV1UBitmap(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UFROMEM_CTX_SWITCH)] = new NV1UFromem(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UTOMEM_CTX_SWITCH)] = new NV1UToMem(this);
+        pgraph.classes[NV1_CLASS_ID(NV_UBTMB_CTX_SWITCH)] = new NV1UTexture(this, 1, true);
+        pgraph.classes[NV1_CLASS_ID(NV_UQTMB_CTX_SWITCH)] = new NV1UTexture(this, 2, true);
+
+        pgraph.rop3 = NV1_ROP_SRCCOPY;
+        pgraph.plane_mask = 0x3FFFFFFF;
+        pgraph.beta = 0x7F800000;
+
+        // nothing is clipped until the driver sets it up. These are the largest each register holds, so it's the surface that
+        // limits drawing whatever mode is set later
+        pgraph.canvas_min = 0;
+        pgraph.canvas_max = 0x07FF07FF;
+        pgraph.clip0_min = 0;
+        pgraph.clip0_max = 0x07FF07FF;
+        pgraph.abs_uclip_xmin = 0;
+        pgraph.abs_uclip_ymin = 0;
+        pgraph.abs_uclip_xmax = 0x1FFFF;
+        pgraph.abs_uclip_ymax = 0x1FFFF;
+
+        // the pattern is opaque until something says otherwise
+        pgraph.patt_0_a = 0xFF;
+        pgraph.patt_1_a = 0xFF;
+    }
+
+    // Execute a method pulled out of CACHE1.
+    // method is the subchannel and method offset, in the same format as NV_PFIFO_CACHE1_METHOD
+    void NV1::PGRAPHMethod(uint32_t method, uint32_t param)
+    {
+        // Keep these up to date for the trap handler
+        pgraph.trapped_addr = method;
+        pgraph.trapped_data = param;
+
+        // The class comes from the object bound to the subchannel
+        uint32_t subchannel = (method >> 13) & 0x07;
+        uint32_t class_id = (pfifo.cache1.cache_data.context[subchannel] >> 16) & 0x7F;
+        NV1UBase* object = pgraph.classes[class_id];
+
+        if (!object)
+        {
+            Logging_LogChannel("PGRAPH: Method 0x%04x for unimplemented class 0x%02x", LogChannel::Debug, method & NV1_USER_SUBCHANNEL_MASK, class_id);
+            return;
+        }
+
+        // readbacks only have to be finished before something else happens
+        if (class_id != NV1_CLASS_ID(NV_UTOMEM_CTX_SWITCH))
+            PGRAPHWaitForReadback();
+
+        // batches have to be drawn before another class can draw over them or change how they are drawn
+        if (pgraph.batch_object != object)
+            PGRAPHFlush();
+
+        object->Method(method & NV1_USER_SUBCHANNEL_MASK & ~0x03, param);
+    }
+
+    // Draw whatever the class that is batching has queued up
+    void NV1::PGRAPHFlush()
+    {
+        NV1UBase* object = pgraph.batch_object;
+
+        if (!object)
+            return;
+
+        pgraph.batch_object = nullptr;
+        object->Flush();
+    }
+
+    void NV1UBase::Method(uint32_t offset, uint32_t param)
+    {
+        Logging_LogChannel("PGRAPH: Unimplemented method 0x%04x (param 0x%08x)", LogChannel::Debug, offset, param);
+    }
+
+    NV1::PGRAPHSurface NV1::PGRAPHGetSurface()
+    {
+        PGRAPHSurface surface = { };
+        uint32_t depth = (pfb.config >> 8) & 0x03;
+
+        surface.width = nv1_pfb_resolution_width[(pfb.config >> 4) & 0x07];
+
+        // PGRAPH doesn't draw at 4bpp
+        if (depth == NV_PFB_CONFIG_0_PIXEL_DEPTH_4_BITS)
+            return surface;
+
+        surface.bytes_per_pixel = 1 << (depth - 1);
+        surface.pitch = surface.width * surface.bytes_per_pixel;
+        surface.height = settings.vram_amount / surface.pitch;
+        return surface;
+    }
+
+    // Sign extend a register field that is bits wide
+    static inline int32_t PGRAPHSignExtend(uint32_t value, uint32_t bits)
+    {
+        return (int32_t)(value << (32 - bits)) >> (32 - bits);
+    }
+
+    // Where drawing is allowed. The surface, canvas, clip 0 and the user clip rectangle all have to allow a pixel for it to be drawn.
+    // It's only worked out again if one of the registers it comes from has changed since last time
+    NV1::PGRAPHRect NV1::PGRAPHGetClip(const PGRAPHSurface& surface)
+    {
+        PGRAPHClipState& clip_state = state.clip;
+        uint32_t registers[NV1_PGRAPH_CLIP_REGISTERS] =
+        {
+            pfb.config, pgraph.canvas_min, pgraph.canvas_max, pgraph.clip0_min, pgraph.clip0_max,
+            pgraph.abs_uclip_xmin, pgraph.abs_uclip_ymin, pgraph.abs_uclip_xmax, pgraph.abs_uclip_ymax,
+        };
+
+        if (clip_state.valid
+        && !memcmp(clip_state.registers, registers, sizeof(registers)))
+            return { clip_state.left, clip_state.top, clip_state.right, clip_state.bottom };
+
+        PGRAPHRect clip = { 0, 0, (int32_t)surface.width, (int32_t)surface.height };
+
+        // every limit is a signed field as wide as the register: 16 bits for the canvas minimum, 12 for the canvas maximum and
+        // clip 0, and 18 for the user clip. The relative user clip isn't used, it's write only and NV_UCLIP only ever sets
+        // the absolute one
+        PGRAPHRect limits[] =
+        {
+            { PGRAPHSignExtend(pgraph.canvas_min, 16), PGRAPHSignExtend(pgraph.canvas_min >> 16, 16), PGRAPHSignExtend(pgraph.canvas_max, 12), PGRAPHSignExtend(pgraph.canvas_max >> 16, 12) },
+            { PGRAPHSignExtend(pgraph.clip0_min, 12), PGRAPHSignExtend(pgraph.clip0_min >> 16, 12), PGRAPHSignExtend(pgraph.clip0_max, 12), PGRAPHSignExtend(pgraph.clip0_max >> 16, 12) },
+            { PGRAPHSignExtend(pgraph.abs_uclip_xmin, 18), PGRAPHSignExtend(pgraph.abs_uclip_ymin, 18), PGRAPHSignExtend(pgraph.abs_uclip_xmax, 18), PGRAPHSignExtend(pgraph.abs_uclip_ymax, 18) },
+        };
+
+        for (const PGRAPHRect& limit : limits)
+        {
+            clip.left = std::max(clip.left, limit.left);
+            clip.top = std::max(clip.top, limit.top);
+            clip.right = std::min(clip.right, limit.right);
+            clip.bottom = std::min(clip.bottom, limit.bottom);
+        }
+
+        clip_state.valid = true;
+        memcpy(clip_state.registers, registers, sizeof(registers));
+        clip_state.left = clip.left;
+        clip_state.top = clip.top;
+        clip_state.right = clip.right;
+        clip_state.bottom = clip.bottom;
+        return clip;
+    }
+
+    // Cut a primitive's bounds down to the clip rectangle when it's set up, and count what happened to it.
+    // Returns false if none of it is left to draw
+    bool NV1::PGRAPHClipBounds(PGRAPHRect& bounds, const PGRAPHRect& clip)
+    {
+        PGRAPHRect clipped = bounds;
+
+        if (!PGRAPHClipRect(clipped, clip))
+        {
+            state.clip.rejected.store(state.clip.rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (clipped.left == bounds.left
+        && clipped.top == bounds.top
+        && clipped.right == bounds.right
+        && clipped.bottom == bounds.bottom)
+            state.clip.accepted.store(state.clip.accepted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        else
+            state.clip.trimmed.store(state.clip.trimmed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        bounds = clipped;
+        return true;
+    }
+
+    // The same without counting, for the pieces of a primitive that has already been counted, like the lines of an image
+    bool NV1::PGRAPHClipRect(PGRAPHRect& bounds, const PGRAPHRect& clip)
+    {
+        bounds =
+        {
+            std::max(bounds.left, clip.left), std::max(bounds.top, clip.top),
+            std::min(bounds.right, clip.right), std::min(bounds.bottom, clip.bottom),
+        };
+
+        return bounds.left < bounds.right
+        && bounds.top < bounds.bottom;
+    }
+
+    // Count a primitive that is drawn a piece at a time, once, when the class sets it up
+    void NV1::PGRAPHCountClip(int32_t x, int32_t y, uint32_t width, uint32_t height)
+    {
+        PGRAPHRect bounds = { x, y, x + (int32_t)width, y + (int32_t)height };
+
+        PGRAPHClipBounds(bounds, PGRAPHGetClip(PGRAPHGetSurface()));
+    }
+
+    // Truncate a colour to the depth of the framebuffer and repeat it across a dword, for the span fills
+    uint32_t NV1::PGRAPHRepeatColor(uint32_t color, const PGRAPHSurface& surface)
+    {
+        if (surface.bytes_per_pixel == 1)
+            return (color & 0xFF) * 0x01010101;
+        else if (surface.bytes_per_pixel == 2)
+            return (color & 0xFFFF) * 0x00010001;
+
+        return color;
+    }
+
+    // Fill a rectangle with a solid colour
+    void NV1::PGRAPHFillRect(int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t color)
+    {
+        PGRAPHSurface surface = PGRAPHGetSurface();
+        PGRAPHRect bounds = { x, y, x + (int32_t)width, y + (int32_t)height };
+
+        if (!PGRAPHClipBounds(bounds, PGRAPHGetClip(surface)))
+            return;
+
+        int32_t left = bounds.left;
+        int32_t top = bounds.top;
+        int32_t right = bounds.right;
+        int32_t bottom = bounds.bottom;
+
+        uint32_t pattern = PGRAPHRepeatColor(color, surface);
+        uint8_t* row = state.video_ram8 + top * surface.pitch + left * surface.bytes_per_pixel;
+        uint32_t bytes = (right - left) * surface.bytes_per_pixel;
+        uint8_t rop = pgraph.rop3 & 0xFF;
+        PGRAPHWriteMask mask = PGRAPHGetWriteMask(surface);
+
+        // the colour is the source, so SRCCOPY is a plain fill
+        if (rop == NV1_ROP_SRCCOPY
+        && !mask.active)
+        {
+            PGRAPHFillSpanFn fill_span = PGRAPHGetFillSpan();
+
+            for (int32_t line = top; line < bottom; line++, row += surface.pitch)
+                fill_span(row, bytes, pattern);
+
+            return;
+        }
+
+        PGRAPHRop3SpanFn rop_span = PGRAPHGetRop3Span(rop);
+        const PGRAPHPatternCache* pattern_cache = PGRAPHGetRopPattern(rop, surface);
+        alignas(32) uint8_t src_row[NV1_PGRAPH_MAX_PITCH];
+
+        PGRAPHFillSpanScalar(src_row, bytes, pattern);
+
+        for (int32_t line = top; line < bottom; line++, row += surface.pitch)
+        {
+            if (rop == NV1_ROP_SRCCOPY)
+            {
+                PGRAPHWriteSpanMasked(row, src_row, src_row, right - left, surface, mask);
+                continue;
+            }
+
+            PGRAPHWriteSpanRop(row, src_row, left, line, right - left, surface, mask, rop_span, pattern_cache);
+        }
+    }
+
+    // Convert a colour in PGRAPH's internal 10:10:10 format to the framebuffer's
+    uint32_t NV1::PGRAPHConvertColor(uint32_t color, const PGRAPHSurface& surface)
+    {
+        uint32_t red = (color >> 20) & 0x3FF;
+        uint32_t green = (color >> 10) & 0x3FF;
+        uint32_t blue = color & 0x3FF;
+
+        switch (surface.bytes_per_pixel)
+        {
+            case 4:
+                return ((red >> 2) << 16) | ((green >> 2) << 8) | (blue >> 2);
+            case 2:
+                return ((red >> 5) << 10) | ((green >> 5) << 5) | (blue >> 5);
+            default:
+                return color & 0xFF;    // indexed
+        }
+    }
+
+    // Convert a colour in the framebuffer's format to PGRAPH's internal 10:10:10 format. The top bits of each channel are
+    // repeated into the bottom ones, so that converting it back gives the same colour
+    uint32_t NV1::PGRAPHUnconvertColor(uint32_t color, const PGRAPHSurface& surface)
+    {
+        uint32_t red, green, blue;
+
+        switch (surface.bytes_per_pixel)
+        {
+            case 4:
+                red = (color >> 16) & 0xFF;
+                green = (color >> 8) & 0xFF;
+                blue = color & 0xFF;
+                return (((red << 2) | (red >> 6)) << 20) | (((green << 2) | (green >> 6)) << 10) | ((blue << 2) | (blue >> 6));
+            case 2:
+                red = (color >> 10) & 0x1F;
+                green = (color >> 5) & 0x1F;
+                blue = color & 0x1F;
+                return (((red << 5) | red) << 20) | (((green << 5) | green) << 10) | ((blue << 5) | blue);
+            default:
+                return color & 0xFF;    // indexed
+        }
+    }
+
+    // Convert an object's colour, which is in the framebuffer's format, to the internal format with bit 30 set if it's opaque.
+    // Colours only have alpha when the object's context enables it, and then it's bit 15 at 16bpp and the top byte at 32bpp.
+    // Indexed colours are always opaque
+    uint32_t NV1::PGRAPHObjectColor(uint32_t color, const PGRAPHSurface& surface)
+    {
+        bool opaque = true;
+
+        if ((pgraph.ctx_switch >> 13) & 0x01)
+        {
+            switch (surface.bytes_per_pixel)
+            {
+                case 4:
+                    opaque = (color >> 24) != 0;
+                    break;
+                case 2:
+                    opaque = (color >> 15) & 0x01;
+                    break;
+            }
+        }
+
+        return PGRAPHUnconvertColor(color, surface) | ((uint32_t)opaque << 30);
+    }
+
+    // Get the pattern expanded at the depth of the framebuffer. It's only expanded again when the pattern or the depth change
+    const NV1::PGRAPHPatternCache& NV1::PGRAPHGetPattern(const PGRAPHSurface& surface)
+    {
+        PGRAPHPatternCache& pattern = state.pattern;
+
+        if (pattern.valid
+        && pattern.shape == pgraph.pattern_shape
+        && pattern.bitmap[0] == pgraph.pattern_bitmap[0]
+        && pattern.bitmap[1] == pgraph.pattern_bitmap[1]
+        && pattern.color_0 == pgraph.patt_0_rgb
+        && pattern.color_1 == pgraph.patt_1_rgb
+        && pattern.alpha_0 == pgraph.patt_0_a
+        && pattern.alpha_1 == pgraph.patt_1_a
+        && pattern.bytes_per_pixel == surface.bytes_per_pixel)
+            return pattern;
+
+        pattern.valid = true;
+        pattern.shape = pgraph.pattern_shape;
+        pattern.bitmap[0] = pgraph.pattern_bitmap[0];
+        pattern.bitmap[1] = pgraph.pattern_bitmap[1];
+        pattern.color_0 = pgraph.patt_0_rgb;
+        pattern.color_1 = pgraph.patt_1_rgb;
+        pattern.alpha_0 = pgraph.patt_0_a;
+        pattern.alpha_1 = pgraph.patt_1_a;
+        pattern.bytes_per_pixel = surface.bytes_per_pixel;
+
+        uint64_t bitmap = ((uint64_t)pgraph.pattern_bitmap[1] << 32) | pgraph.pattern_bitmap[0];
+        uint32_t colors[2] = { PGRAPHConvertColor(pgraph.patt_0_rgb, surface), PGRAPHConvertColor(pgraph.patt_1_rgb, surface) };
+
+        // there's no blending with the pattern's alpha, a colour is either drawn or it isn't
+        uint8_t opaque[2] = { (pgraph.patt_0_a & 0xFF) != 0, (pgraph.patt_1_a & 0xFF) != 0 };
+
+        pattern.transparent = false;
+
+        for (uint32_t y = 0; y < NV1_PGRAPH_PATTERN_SIZE; y++)
+        {
+            uint8_t* row = pattern.rows[y];
+
+            for (uint32_t x = 0; x < NV1_PGRAPH_PATTERN_SIZE * 2; x++, row += surface.bytes_per_pixel)
+            {
+                uint32_t bit;
+
+                switch (pgraph.pattern_shape & 0x03)
+                {
+                    case NV_PGRAPH_PATTERN_SHAPE_VALUE_8X8:
+                        bit = ((y & 0x07) << 3) | (x & 0x07);
+                        break;
+                    case NV_PGRAPH_PATTERN_SHAPE_VALUE_64X1:
+                        bit = x & 0x3F;
+                        break;
+                    default:
+                        bit = y;
+                        break;
+                }
+
+                uint32_t index = (bitmap >> bit) & 0x01;
+
+                memcpy(row, &colors[index], surface.bytes_per_pixel);
+
+                if (x < NV1_PGRAPH_PATTERN_SIZE)
+                {
+                    pattern.opaque[y][x] = opaque[index];
+                    pattern.transparent |= !opaque[index];
+                }
+            }
+        }
+
+        return pattern;
+    }
+
+    // The expanded pattern if the ROP uses it, otherwise nullptr. Look this up once per primitive, like the ROP
+    const NV1::PGRAPHPatternCache* NV1::PGRAPHGetRopPattern(uint8_t rop, const PGRAPHSurface& surface)
+    {
+        return (((rop >> 4) ^ rop) & 0x0F) ? &PGRAPHGetPattern(surface) : nullptr;
+    }
+
+    // Expand count pixels of the pattern, starting at (x, y), into row at the depth of the framebuffer. The pattern repeats
+    // every 64 pixels, so this is copying the same 64 pixels over and over
+    void NV1::PGRAPHExpandPattern(int32_t x, int32_t y, uint32_t count, const PGRAPHSurface& surface, uint8_t* row)
+    {
+        PGRAPHExpandPattern(PGRAPHGetPattern(surface), x, y, count, surface, row);
+    }
+
+    // The same from a pattern that has already been expanded, which doesn't touch PGRAPH at all
+    void NV1::PGRAPHExpandPattern(const PGRAPHPatternCache& pattern, int32_t x, int32_t y, uint32_t count, const PGRAPHSurface& surface, uint8_t* row)
+    {
+        const uint8_t* src = pattern.rows[y & (NV1_PGRAPH_PATTERN_SIZE - 1)] + (x & (NV1_PGRAPH_PATTERN_SIZE - 1)) * surface.bytes_per_pixel;
+        uint32_t bytes = count * surface.bytes_per_pixel;
+        uint32_t repeat = NV1_PGRAPH_PATTERN_SIZE * surface.bytes_per_pixel;
+
+        for (; bytes >= repeat; bytes -= repeat, row += repeat)
+            memcpy(row, src, repeat);
+
+        memcpy(row, src, bytes);
+    }
+
+    // Put back the pixels of a span at (x, y) where the pattern is transparent. original is what dst was before the span
+    // was drawn
+    void NV1::PGRAPHKeepTransparent(uint8_t* dst, const uint8_t* original, const PGRAPHPatternCache& pattern, int32_t x, int32_t y, uint32_t pixels, const PGRAPHSurface& surface)
+    {
+        const uint8_t* opaque = pattern.opaque[y & (NV1_PGRAPH_PATTERN_SIZE - 1)];
+        uint32_t bytes_per_pixel = surface.bytes_per_pixel;
+
+        for (uint32_t pixel = 0; pixel < pixels; pixel++, dst += bytes_per_pixel, original += bytes_per_pixel)
+        {
+            if (!opaque[(x + pixel) & (NV1_PGRAPH_PATTERN_SIZE - 1)])
+                memcpy(dst, original, bytes_per_pixel);
+        }
+    }
+
+    // What beta blending, the chroma key and the plane mask do to writes, in the framebuffer's format
+    NV1::PGRAPHWriteMask NV1::PGRAPHGetWriteMask(const PGRAPHSurface& surface)
+    {
+        PGRAPHWriteMask mask = { };
+        uint32_t pixel_mask = (surface.bytes_per_pixel == 4) ? 0xFFFFFFFF : (1 << (surface.bytes_per_pixel << 3)) - 1;
+
+        // indexed colour can't be blended
+        mask.blend = pgraph.blend_beta < NV1_PGRAPH_BETA_ONE && surface.bytes_per_pixel > 1;
+        mask.beta = pgraph.blend_beta;
+
+        // bits that aren't colour, like bit 15 at 16bpp and the top byte at 32bpp, don't take part in the key
+        mask.chroma = (pgraph.chroma_key >> 30) & 0x01;
+        mask.chroma_mask = PGRAPHConvertColor(0x3FFFFFFF, surface);
+        mask.chroma_key = PGRAPHConvertColor(pgraph.chroma_key, surface) & mask.chroma_mask;
+
+        // bits that the 10:10:10 plane mask doesn't cover, like the top byte at 32bpp, are always written
+        mask.plane_mask = (PGRAPHConvertColor(pgraph.plane_mask, surface) | ~mask.chroma_mask) & pixel_mask;
+        mask.active = mask.blend || mask.chroma || mask.plane_mask != pixel_mask;
+        return mask;
+    }
+
+    // Write pixels through beta blending, the chroma key and the plane mask. result is what would be written without them,
+    // src is the source pixels that get tested against the chroma key
+    void NV1::PGRAPHWriteSpanMasked(uint8_t* dst, const uint8_t* result, const uint8_t* src, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask)
+    {
+        alignas(32) uint8_t blended[NV1_PGRAPH_MAX_PITCH];
+
+        if (mask.blend)
+        {
+            PGRAPHBlendSpan(blended, result, dst, pixels, mask.beta, surface);
+            result = blended;
+        }
+
+        PGRAPHMaskSpan(dst, result, src, pixels, surface, mask);
+    }
+
+    // Screen to screen blit
+    void NV1::PGRAPHBlit(int32_t src_x, int32_t src_y, int32_t dst_x, int32_t dst_y, uint32_t width, uint32_t height)
+    {
+        PGRAPHSurface surface = PGRAPHGetSurface();
+        // the source has to be inside the framebuffer, then the destination is clipped
+        PGRAPHRect bounds =
+        {
+            std::max(dst_x, dst_x - src_x), std::max(dst_y, dst_y - src_y),
+            std::min(dst_x + (int32_t)width, dst_x - src_x + (int32_t)surface.width), std::min(dst_y + (int32_t)height, dst_y - src_y + (int32_t)surface.height),
+        };
+
+        if (!PGRAPHClipBounds(bounds, PGRAPHGetClip(surface)))
+            return;
+
+        int32_t left = bounds.left;
+        int32_t top = bounds.top;
+        int32_t right = bounds.right;
+        int32_t bottom = bounds.bottom;
+
+        uint32_t bytes_per_pixel = surface.bytes_per_pixel;
+        uint32_t bytes = (right - left) * bytes_per_pixel;
+        uint8_t* dst = state.video_ram8 + top * surface.pitch + left * bytes_per_pixel;
+        uint8_t* src = state.video_ram8 + (src_y + top - dst_y) * surface.pitch + (src_x + left - dst_x) * bytes_per_pixel;
+        int32_t line = top;
+        int32_t line_step = 1;
+        ptrdiff_t pitch = surface.pitch;
+
+        // going down the screen, copy from the bottom up so that rows aren't overwritten before they are read
+        if (dst_y > src_y)
+        {
+            src += (bottom - top - 1) * pitch;
+            dst += (bottom - top - 1) * pitch;
+            line = bottom - 1;
+            line_step = -1;
+            pitch = -pitch;
+        }
+
+        uint8_t rop = pgraph.rop3 & 0xFF;
+        PGRAPHWriteMask mask = PGRAPHGetWriteMask(surface);
+
+        // window moves and scrolling. memmove takes care of overlap within a row
+        if (rop == NV1_ROP_SRCCOPY
+        && !mask.active)
+        {
+            for (int32_t row = top; row < bottom; row++, src += pitch, dst += pitch)
+                memmove(dst, src, bytes);
+
+            return;
+        }
+
+        // rows are already done in an order where they don't overwrite a source row before it's read, so only a blit within
+        // the same rows needs a copy of the source row
+        PGRAPHRop3SpanFn rop_span = PGRAPHGetRop3Span(rop);
+        const PGRAPHPatternCache* pattern_cache = PGRAPHGetRopPattern(rop, surface);
+        alignas(32) uint8_t src_row[NV1_PGRAPH_MAX_PITCH];
+        bool same_row = dst_y == src_y;
+
+        for (int32_t row = top; row < bottom; row++, line += line_step, src += pitch, dst += pitch)
+        {
+            const uint8_t* src_pixels = src;
+
+            if (same_row)
+            {
+                memcpy(src_row, src, bytes);
+                src_pixels = src_row;
+            }
+
+            // colour keyed sprites are SRCCOPY, where the source is already the result
+            if (rop == NV1_ROP_SRCCOPY)
+            {
+                PGRAPHWriteSpanMasked(dst, src_pixels, src_pixels, right - left, surface, mask);
+                continue;
+            }
+
+            PGRAPHWriteSpanRop(dst, src_pixels, left, line, right - left, surface, mask, rop_span, pattern_cache);
+        }
+    }
+
+    // Draw one scanline of an image. pixels are in the framebuffer's format and are the source for the ROP
+    void NV1::PGRAPHImageLine(int32_t x, int32_t y, uint32_t width, const uint8_t* pixels)
+    {
+        PGRAPHSurface surface = PGRAPHGetSurface();
+        PGRAPHRect bounds = { x, y, x + (int32_t)width, y + 1 };
+
+        // the class counted the whole image
+        if (!PGRAPHClipRect(bounds, PGRAPHGetClip(surface)))
+            return;
+
+        uint8_t* dst = state.video_ram8 + y * surface.pitch + bounds.left * surface.bytes_per_pixel;
+
+        PGRAPHWriteSpan(dst, pixels + (bounds.left - x) * surface.bytes_per_pixel, bounds.left, y, bounds.right - bounds.left, surface, PGRAPHGetWriteMask(surface));
+    }
+
+    // Draw a span that has already been clipped, with the current ROP. src is the source pixels for the span at (x, y)
+    void NV1::PGRAPHWriteSpan(uint8_t* dst, const uint8_t* src, int32_t x, int32_t y, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask)
+    {
+        uint32_t bytes = pixels * surface.bytes_per_pixel;
+        uint8_t rop = pgraph.rop3 & 0xFF;
+
+        if (rop == NV1_ROP_SRCCOPY)
+        {
+            if (mask.active)
+                PGRAPHWriteSpanMasked(dst, src, src, pixels, surface, mask);
+            else
+                memcpy(dst, src, bytes);
+
+            return;
+        }
+
+        PGRAPHWriteSpanRop(dst, src, x, y, pixels, surface, mask, PGRAPHGetRop3Span(rop), PGRAPHGetRopPattern(rop, surface));
+    }
+
+    // The same, with the ROP and the pattern already looked up, for primitives that are drawn a lot of spans at a time.
+    // pattern is nullptr if the ROP doesn't use it
+    void NV1::PGRAPHWriteSpanRop(uint8_t* dst, const uint8_t* src, int32_t x, int32_t y, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask,
+    PGRAPHRop3SpanFn rop_span, const PGRAPHPatternCache* pattern)
+    {
+        uint32_t bytes = pixels * surface.bytes_per_pixel;
+        alignas(32) uint8_t pattern_row[NV1_PGRAPH_MAX_PITCH];
+        alignas(32) uint8_t result_row[NV1_PGRAPH_MAX_PITCH];
+        alignas(32) uint8_t original_row[NV1_PGRAPH_MAX_PITCH];
+        bool transparent = pattern && pattern->transparent;
+
+        if (pattern)
+            PGRAPHExpandPattern(*pattern, x, y, pixels, surface, pattern_row);
+
+        // pixels where the pattern is transparent aren't drawn at all
+        if (transparent)
+            memcpy(original_row, dst, bytes);
+
+        if (!mask.active)
+            rop_span(dst, src, pattern_row, bytes);
+        else
+        {
+            memcpy(result_row, dst, bytes);
+            rop_span(result_row, src, pattern_row, bytes);
+            PGRAPHWriteSpanMasked(dst, result_row, src, pixels, surface, mask);
+        }
+
+        if (transparent)
+            PGRAPHKeepTransparent(dst, original_row, *pattern, x, y, pixels, surface);
+    }
+}
@@ -0,0 +1,98 @@
+//
+// nv1_pgraph_beta.cpp
+// NV1 Beta Blending
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // Channels are widened to 16 bits so that they can be multiplied by a beta of up to 256, which fills a 16 byte vector
+    // with 8 of them
+    typedef uint8_t PGRAPHBetaBytes __attribute__((vector_size(8)));
+    typedef uint16_t PGRAPHBetaVector __attribute__((vector_size(16)));
+
+    // src * beta + dst * (1 - beta), rounded. Works on one channel, or a vector of them
+    template <typename T> static inline T PGRAPHBlendChannel(T src, T dst, uint16_t beta)
+    {
+        return (src * beta + dst * (uint16_t)(NV1_PGRAPH_BETA_ONE - beta) + 128) >> 8;
+    }
+
+    // Blend each 5-bit channel of 1:5:5:5 pixels. The top bit comes from the source
+    template <typename T> static inline T PGRAPHBlend555(T src, T dst, uint16_t beta)
+    {
+        T red = PGRAPHBlendChannel<T>((src >> 10) & 0x1F, (dst >> 10) & 0x1F, beta);
+        T green = PGRAPHBlendChannel<T>((src >> 5) & 0x1F, (dst >> 5) & 0x1F, beta);
+        T blue = PGRAPHBlendChannel<T>(src & 0x1F, dst & 0x1F, beta);
+
+        return (src & 0x8000) | (red << 10) | (green << 5) | blue;
+    }
+
+    // Blend src over dst into out. beta is out of 256. Indexed colour can't be blended, so it's just the source
+    void NV1::PGRAPHBlendSpan(uint8_t* out, const uint8_t* src, const uint8_t* dst, uint32_t pixels, uint32_t beta, const PGRAPHSurface& surface)
+    {
+        uint32_t bytes = pixels * surface.bytes_per_pixel;
+
+        if (surface.bytes_per_pixel == 2)
+        {
+            for (; bytes >= sizeof(PGRAPHBetaVector); bytes -= sizeof(PGRAPHBetaVector))
+            {
+                PGRAPHBetaVector s, d;
+
+                memcpy(&s, src, sizeof(s));
+                memcpy(&d, dst, sizeof(d));
+
+                s = PGRAPHBlend555(s, d, beta);
+                memcpy(out, &s, sizeof(s));
+
+                out += sizeof(PGRAPHBetaVector);
+                src += sizeof(PGRAPHBetaVector);
+                dst += sizeof(PGRAPHBetaVector);
+            }
+
+            for (; bytes; bytes -= 2, out += 2, src += 2, dst += 2)
+            {
+                uint16_t s, d;
+
+                memcpy(&s, src, sizeof(s));
+                memcpy(&d, dst, sizeof(d));
+
+                s = PGRAPHBlend555<uint32_t>(s, d, beta);
+                memcpy(out, &s, sizeof(s));
+            }
+        }
+        else if (surface.bytes_per_pixel == 4)
+        {
+            // every byte is a channel, including the unused top one
+            for (; bytes >= sizeof(PGRAPHBetaBytes); bytes -= sizeof(PGRAPHBetaBytes))
+            {
+                PGRAPHBetaBytes s, d;
+
+                memcpy(&s, src, sizeof(s));
+                memcpy(&d, dst, sizeof(d));
+
+                PGRAPHBetaVector blended = PGRAPHBlendChannel(__builtin_convertvector(s, PGRAPHBetaVector), __builtin_convertvector(d, PGRAPHBetaVector), beta);
+
+                s = __builtin_convertvector(blended, PGRAPHBetaBytes);
+                memcpy(out, &s, sizeof(s));
+
+                out += sizeof(PGRAPHBetaBytes);
+                src += sizeof(PGRAPHBetaBytes);
+                dst += sizeof(PGRAPHBetaBytes);
+            }
+
+            for (; bytes; bytes--, out++, src++, dst++)
+                *out = PGRAPHBlendChannel<uint32_t>(*src, *dst, beta);
+        }
+        else
+            memcpy(out, src, bytes);
+    }
+
+    // NV_UBETA's beta, out of 256. The largest value NV_PGRAPH_BETA can hold is taken as 1, so beta classes can be opaque
+    uint32_t NV1::PGRAPHGetBetaFactor()
+    {
+        uint32_t fraction = (pgraph.beta >> 23) & 0xFF;
+
+        return fraction + (fraction >> 7);
+    }
+}
@@ -0,0 +1,205 @@
+//
+// nv1_pgraph_line.cpp
+// NV1 Line Rasterisation
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // Draw a horizontal run of a line that has already been clipped
+    static inline void PGRAPHLineRun(NV1::PGRAPHLineState& line_state, int32_t x, int32_t y, uint32_t pixels)
+    {
+        uint32_t bytes_per_pixel = line_state.surface.bytes_per_pixel;
+        uint8_t* dst = line_state.gpu->state.video_ram8 + y * line_state.surface.pitch + x * bytes_per_pixel;
+
+        if (line_state.solid)
+            line_state.fill_span(dst, pixels * bytes_per_pixel, line_state.pattern);
+        else
+            line_state.gpu->PGRAPHWriteSpanRop(dst, line_state.color_row, x, y, pixels, line_state.surface, line_state.mask, line_state.rop_span, line_state.pattern_cache);
+    }
+
+    // Bresenham. The error term is the fraction of a pixel that the minor axis has moved, in units of 1 / (2 * major).
+    // Each octant gets its own copy so that the direction of each axis is known at compile time.
+    // Steps first to last (already clipped) are drawn. X-major lines are drawn as horizontal runs
+    template <bool y_major, int32_t step_x, int32_t step_y>
+    static void PGRAPHLineOctant(NV1::PGRAPHLineState& line_state, int32_t x0, int32_t y0, int64_t major, int64_t minor, int64_t first, int64_t last)
+    {
+        int64_t position = 2 * first * minor + major;
+        int64_t offset = position / (2 * major);
+        int64_t error = position % (2 * major);
+
+        int32_t x = x0 + step_x * (int32_t)((y_major) ? offset : first);
+        int32_t y = y0 + step_y * (int32_t)((y_major) ? first : offset);
+
+        if constexpr (y_major)
+        {
+            for (int64_t step = first; step <= last; step++, y += step_y)
+            {
+                PGRAPHLineRun(line_state, x, y, 1);
+
+                error += 2 * minor;
+
+                if (error >= 2 * major)
+                {
+                    error -= 2 * major;
+                    x += step_x;
+                }
+            }
+        }
+        else
+        {
+            int32_t run_start = x;
+
+            for (int64_t step = first; step <= last; step++, x += step_x)
+            {
+                error += 2 * minor;
+
+                // the run carries on until Y changes after this pixel
+                if (error < 2 * major
+                && step != last)
+                    continue;
+
+                PGRAPHLineRun(line_state, (step_x > 0) ? run_start : x, y, std::abs(x - run_start) + 1);
+                run_start = x + step_x;
+
+                if (error >= 2 * major)
+                {
+                    error -= 2 * major;
+                    y += step_y;
+                }
+            }
+        }
+    }
+
+    typedef void (*PGRAPHLineOctantFn)(NV1::PGRAPHLineState& line_state, int32_t x0, int32_t y0, int64_t major, int64_t minor, int64_t first, int64_t last);
+
+    // Indexed by (y major << 2) | (x decreasing << 1) | (y decreasing)
+    static constexpr PGRAPHLineOctantFn pgraph_line_octants[8] =
+    {
+        PGRAPHLineOctant<false, 1, 1>, PGRAPHLineOctant<false, 1, -1>, PGRAPHLineOctant<false, -1, 1>, PGRAPHLineOctant<false, -1, -1>,
+        PGRAPHLineOctant<true, 1, 1>, PGRAPHLineOctant<true, 1, -1>, PGRAPHLineOctant<true, -1, 1>, PGRAPHLineOctant<true, -1, -1>,
+    };
+
+    // Work out which steps along an axis are inside the clip rectangle. Returns false if none are
+    static inline bool PGRAPHClipLineAxis(int32_t start, int32_t direction, int32_t clip_min, int32_t clip_max, int64_t& min, int64_t& max)
+    {
+        if (direction > 0)
+        {
+            min = clip_min - start;
+            max = clip_max - 1 - start;
+        }
+        else
+        {
+            min = start - (clip_max - 1);
+            max = start - clip_min;
+        }
+
+        return min <= max;
+    }
+
+    // Draw a batch of lines. Lines go from (x0, y0) to (x1, y1), and (x1, y1) is only drawn if last_pixel is set
+    void NV1::PGRAPHLines(std::span<const PGRAPHLine> lines, bool last_pixel)
+    {
+        PGRAPHLineState line_state;
+
+        line_state.gpu = this;
+        line_state.surface = PGRAPHGetSurface();
+        line_state.clip = PGRAPHGetClip(line_state.surface);
+        line_state.mask = PGRAPHGetWriteMask(line_state.surface);
+        uint8_t rop = pgraph.rop3 & 0xFF;
+
+        line_state.solid = rop == NV1_ROP_SRCCOPY && !line_state.mask.active;
+        line_state.fill_span = PGRAPHGetFillSpan();
+        line_state.rop_span = PGRAPHGetRop3Span(rop);
+        line_state.pattern_cache = PGRAPHGetRopPattern(rop, line_state.surface);
+
+        const PGRAPHRect& clip = line_state.clip;
+
+        for (const PGRAPHLine& line : lines)
+        {
+            // same as triangles, software has to split up lines that don't fit in 16 bits
+            if (line.x0 != (int16_t)line.x0
+            || line.y0 != (int16_t)line.y0
+            || line.x1 != (int16_t)line.x1
+            || line.y1 != (int16_t)line.y1)
+            {
+                pgraph.exceptions |= (NV_PGRAPH_EXCEPTIONS_CLIP_XY_ONLY << 24);
+                continue;
+            }
+
+            int32_t step_x = (line.x1 < line.x0) ? -1 : 1;
+            int32_t step_y = (line.y1 < line.y0) ? -1 : 1;
+            int64_t dx = std::abs(line.x1 - line.x0);
+            int64_t dy = std::abs(line.y1 - line.y0);
+            bool y_major = dy > dx;
+            int64_t major = std::max(dx, dy);
+            int64_t minor = std::min(dx, dy);
+
+            // a line with no length is just its last pixel
+            if (!major
+            && !last_pixel)
+                continue;
+
+            // lines that are entirely outside the clip rectangle are thrown out before working out which steps are inside it
+            PGRAPHRect bounds = { std::min(line.x0, line.x1), std::min(line.y0, line.y1), std::max(line.x0, line.x1) + 1, std::max(line.y0, line.y1) + 1 };
+
+            if (!PGRAPHClipBounds(bounds, clip))
+                continue;
+
+            int64_t first = 0;
+            int64_t last = (last_pixel) ? major : major - 1;
+            int64_t min, max;
+
+            // clip the major axis, which moves every step
+            bool visible = (y_major)
+                ? PGRAPHClipLineAxis(line.y0, step_y, clip.top, clip.bottom, min, max)
+                : PGRAPHClipLineAxis(line.x0, step_x, clip.left, clip.right, min, max);
+
+            first = std::max(first, min);
+            last = std::min(last, max);
+
+            // then the minor axis, which has moved floor((2 * step * minor + major) / (2 * major)) pixels by each step
+            visible = visible && ((y_major)
+                ? PGRAPHClipLineAxis(line.x0, step_x, clip.left, clip.right, min, max)
+                : PGRAPHClipLineAxis(line.y0, step_y, clip.top, clip.bottom, min, max));
+
+            if (!minor)
+                visible = visible && min <= 0 && max >= 0;
+            else
+            {
+                first = std::max(first, Util_CeilDiv<int64_t>(2 * major * min - major, 2 * minor));
+                last = std::min(last, Util_FloorDiv<int64_t>(2 * major * (max + 1) - major - 1, 2 * minor));
+            }
+
+            if (!visible
+            || first > last)
+                continue;
+
+            line_state.pattern = PGRAPHRepeatColor(line.color, line_state.surface);
+
+            if (!line_state.solid)
+                line_state.fill_span(line_state.color_row, std::min<int64_t>(last - first + 1, clip.right - clip.left) * line_state.surface.bytes_per_pixel, line_state.pattern);
+
+            // axis aligned lines, which are most of them in CAD drawings and UI, are a single run or a column
+            if (!minor)
+            {
+                if (!y_major)
+                {
+                    int32_t start = line.x0 + step_x * (int32_t)((step_x > 0) ? first : last);
+                    PGRAPHLineRun(line_state, start, line.y0, last - first + 1);
+                }
+                else
+                {
+                    for (int64_t step = first; step <= last; step++)
+                        PGRAPHLineRun(line_state, line.x0, line.y0 + step_y * (int32_t)step, 1);
+                }
+
+                continue;
+            }
+
+            uint32_t octant = (y_major << 2) | ((step_x < 0) << 1) | (step_y < 0);
+            pgraph_line_octants[octant](line_state, line.x0, line.y0, major, minor, first, last);
+        }
+    }
+}
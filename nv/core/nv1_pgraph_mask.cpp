@@ -0,0 +1,72 @@
+//
+// nv1_pgraph_mask.cpp
+// NV1 Chroma Key and Plane Mask
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // 16 bytes of pixels at a time, split into lanes the size of a pixel so the chroma key can be compared a pixel at a time
+    typedef uint8_t PGRAPHMaskVector8 __attribute__((vector_size(16)));
+    typedef uint16_t PGRAPHMaskVector16 __attribute__((vector_size(16)));
+    typedef uint32_t PGRAPHMaskVector32 __attribute__((vector_size(16)));
+
+    // Select between result and dst a bit at a time. A pixel whose colour bits match the key keeps all of dst, otherwise the
+    // plane mask picks the bits. Vector compares give all ones or all zeroes for each lane, so there are no branches
+    template <typename V, typename T> static void PGRAPHMaskLanes(uint8_t* dst, const uint8_t* result, const uint8_t* src, uint32_t bytes, const NV1::PGRAPHWriteMask& mask)
+    {
+        T chroma = (mask.chroma) ? (T)~0u : 0;
+        V chroma_key = V{} + (T)mask.chroma_key;
+        V chroma_mask = V{} + (T)mask.chroma_mask;
+        V plane_mask = V{} + (T)mask.plane_mask;
+
+        for (; bytes >= sizeof(V); bytes -= sizeof(V), dst += sizeof(V), result += sizeof(V), src += sizeof(V))
+        {
+            V s, d, r;
+
+            memcpy(&s, src, sizeof(s));
+            memcpy(&d, dst, sizeof(d));
+            memcpy(&r, result, sizeof(r));
+
+            V write = plane_mask & ~((V)((s & chroma_mask) == chroma_key) & chroma);
+
+            d = (r & write) | (d & ~write);
+            memcpy(dst, &d, sizeof(d));
+        }
+
+        // the rest the same way, a pixel at a time
+        for (; bytes; bytes -= sizeof(T), dst += sizeof(T), result += sizeof(T), src += sizeof(T))
+        {
+            T s, d, r;
+
+            memcpy(&s, src, sizeof(s));
+            memcpy(&d, dst, sizeof(d));
+            memcpy(&r, result, sizeof(r));
+
+            T write = mask.plane_mask & ~(((T)(s & mask.chroma_mask) == (T)mask.chroma_key) ? chroma : 0);
+
+            d = (r & write) | (d & ~write);
+            memcpy(dst, &d, sizeof(d));
+        }
+    }
+
+    // Write result over dst through the chroma key and plane mask in one pass. src is what gets tested against the key
+    void NV1::PGRAPHMaskSpan(uint8_t* dst, const uint8_t* result, const uint8_t* src, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask)
+    {
+        uint32_t bytes = pixels * surface.bytes_per_pixel;
+
+        switch (surface.bytes_per_pixel)
+        {
+            case 1:
+                PGRAPHMaskLanes<PGRAPHMaskVector8, uint8_t>(dst, result, src, bytes, mask);
+                break;
+            case 2:
+                PGRAPHMaskLanes<PGRAPHMaskVector16, uint16_t>(dst, result, src, bytes, mask);
+                break;
+            default:
+                PGRAPHMaskLanes<PGRAPHMaskVector32, uint32_t>(dst, result, src, bytes, mask);
+                break;
+        }
+    }
+}
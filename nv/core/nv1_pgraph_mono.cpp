@@ -0,0 +1,144 @@
+//
+// nv1_pgraph_mono.cpp
+// NV1 Monochrome to Colour Expansion
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // For each byte of a bitmap, a mask with all the bits of every pixel whose bit is set, for 8 pixels at a given depth.
+    // Expanding a byte is then one lookup and a select between the two colours, which the compiler does with vectors
+    template <uint32_t bytes_per_pixel> struct PGRAPHMonoTable
+    {
+        uint8_t masks[256][8 * bytes_per_pixel];
+    };
+
+    template <uint32_t bytes_per_pixel> static constexpr PGRAPHMonoTable<bytes_per_pixel> PGRAPHMakeMonoTable()
+    {
+        PGRAPHMonoTable<bytes_per_pixel> table = { };
+
+        for (uint32_t bits = 0; bits < 256; bits++)
+        {
+            for (uint32_t byte = 0; byte < 8 * bytes_per_pixel; byte++)
+                table.masks[bits][byte] = ((bits >> (byte / bytes_per_pixel)) & 0x01) ? 0xFF : 0x00;
+        }
+
+        return table;
+    }
+
+    template <uint32_t bytes_per_pixel> static constexpr PGRAPHMonoTable<bytes_per_pixel> pgraph_mono_table = PGRAPHMakeMonoTable<bytes_per_pixel>();
+
+    // Expand count bytes of a bitmap (bit 0 is the leftmost pixel) to 8 pixels each
+    template <uint32_t bytes_per_pixel> static void PGRAPHExpandMono(uint8_t* row, const uint8_t* bits, uint32_t count, uint32_t color0, uint32_t color1)
+    {
+        typedef uint8_t PGRAPHMonoVector __attribute__((vector_size(8 * bytes_per_pixel)));
+        PGRAPHMonoVector colors0, colors1;
+
+        for (uint32_t pixel = 0; pixel < 8; pixel++)
+        {
+            memcpy((uint8_t*)&colors0 + pixel * bytes_per_pixel, &color0, bytes_per_pixel);
+            memcpy((uint8_t*)&colors1 + pixel * bytes_per_pixel, &color1, bytes_per_pixel);
+        }
+
+        for (uint32_t byte = 0; byte < count; byte++, row += sizeof(PGRAPHMonoVector))
+        {
+            PGRAPHMonoVector mask, pixels;
+
+            memcpy(&mask, pgraph_mono_table<bytes_per_pixel>.masks[bits[byte]], sizeof(mask));
+            pixels = (colors1 & mask) | (colors0 & ~mask);
+            memcpy(row, &pixels, sizeof(pixels));
+        }
+    }
+
+    // Find the first pixel from pos that has the given bit, or end if there isn't one. bits has to be readable 8 bytes past end
+    static uint32_t PGRAPHFindMonoBit(const uint8_t* bits, uint32_t pos, uint32_t end, bool value)
+    {
+        while (pos < end)
+        {
+            uint64_t word;
+
+            memcpy(&word, bits + (pos >> 3), sizeof(word));
+
+            if (!value)
+                word = ~word;
+
+            word >>= (pos & 0x07);
+
+            if (word)
+                return std::min<uint32_t>(pos + __builtin_ctzll(word), end);
+
+            pos += 64 - (pos & 0x07);
+        }
+
+        return end;
+    }
+
+    // Draw one scanline of a bitmap in mono_color0 and mono_color1. Bit 0 of bits is the leftmost pixel, and bits has to be
+    // readable 8 bytes past the end of the line. A colour whose bit 30 is clear is transparent (see PGRAPHObjectColor)
+    void NV1::PGRAPHMonoLine(int32_t x, int32_t y, uint32_t width, const uint8_t* bits)
+    {
+        PGRAPHSurface surface = PGRAPHGetSurface();
+        PGRAPHRect bounds = { x, y, x + (int32_t)width, y + 1 };
+
+        bool opaque0 = (pgraph.mono_color0 >> 30) & 0x01;
+        bool opaque1 = (pgraph.mono_color1 >> 30) & 0x01;
+
+        // the class counted the whole bitmap
+        if ((!opaque0 && !opaque1)
+        || !PGRAPHClipRect(bounds, PGRAPHGetClip(surface)))
+            return;
+
+        int32_t left = bounds.left;
+        int32_t right = bounds.right;
+
+        uint32_t bytes_per_pixel = surface.bytes_per_pixel;
+        uint32_t first = left - x;
+        uint32_t end = right - x;
+        uint32_t color0 = PGRAPHConvertColor(pgraph.mono_color0, surface);
+        uint32_t color1 = PGRAPHConvertColor(pgraph.mono_color1, surface);
+
+        // expand whole bytes, then skip the pixels that are left of the clip
+        alignas(32) uint8_t row[NV1_PGRAPH_MAX_PITCH + 64];
+        const uint8_t* first_byte = bits + (first >> 3);
+        uint32_t count = ((end + 7) >> 3) - (first >> 3);
+
+        switch (bytes_per_pixel)
+        {
+            case 1:
+                PGRAPHExpandMono<1>(row, first_byte, count, color0, color1);
+                break;
+            case 2:
+                PGRAPHExpandMono<2>(row, first_byte, count, color0, color1);
+                break;
+            default:
+                PGRAPHExpandMono<4>(row, first_byte, count, color0, color1);
+                break;
+        }
+
+        const uint8_t* src = row + (first & 0x07) * bytes_per_pixel;
+        uint8_t* dst = state.video_ram8 + y * surface.pitch + left * bytes_per_pixel;
+        PGRAPHWriteMask mask = PGRAPHGetWriteMask(surface);
+
+        if (opaque0
+        && opaque1)
+        {
+            PGRAPHWriteSpan(dst, src, left, y, right - left, surface, mask);
+            return;
+        }
+
+        // one colour is transparent, so only draw the runs of the other. Text is mostly runs like this
+        for (uint32_t pos = first; pos < end;)
+        {
+            uint32_t start = PGRAPHFindMonoBit(bits, pos, end, opaque1);
+
+            if (start == end)
+                break;
+
+            pos = PGRAPHFindMonoBit(bits, start, end, !opaque1);
+
+            uint32_t offset = (start - first) * bytes_per_pixel;
+            PGRAPHWriteSpan(dst + offset, src + offset, x + start, y, pos - start, surface, mask);
+        }
+    }
+}
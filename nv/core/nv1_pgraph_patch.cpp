@@ -0,0 +1,359 @@
+//
+// nv1_pgraph_patch.cpp
+// NV1 Texture Patches
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // NV_PGRAPH_SUBDIVIDE fields are log2 of how many pieces something is split into, up to 256
+    static inline uint32_t PGRAPHSubdivideField(uint32_t subdivide, uint32_t shift)
+    {
+        return std::min<uint32_t>((subdivide >> shift) & 0x0F, NV_PGRAPH_SUBDIVIDE_BY_256);
+    }
+
+    // Evaluate a Bezier curve of the given order at 2^level + 1 evenly spaced points. Everything stays in integers: with
+    // t = k / n, n^order * P(t) is a polynomial in k whose last difference is constant. The results are scaled up by n^order
+    template <uint32_t order> static void PGRAPHForwardDifference(const int64_t p[order + 1], uint32_t level, int64_t* out)
+    {
+        int64_t steps = INT64_C(1) << level;
+
+        if constexpr (order == 1)
+        {
+            // n * P(t) = (p1 - p0) * k + p0 * n
+            int64_t value = p[0] * steps;
+            int64_t delta = p[1] - p[0];
+
+            for (int64_t step = 0; step <= steps; step++, value += delta)
+                out[step] = value;
+        }
+        else
+        {
+            // n^2 * P(t) = a * k^2 + b * k * n + c * n^2
+            int64_t a = p[0] - 2 * p[1] + p[2];
+            int64_t b = 2 * (p[1] - p[0]);
+            int64_t value = p[0] * steps * steps;
+            int64_t delta = a + b * steps;
+
+            for (int64_t step = 0; step <= steps; step++)
+            {
+                out[step] = value;
+                value += delta;
+                delta += 2 * a;
+            }
+        }
+    }
+
+    // Round a fixed point number with the given number of fractional bits to the nearest integer
+    static inline int32_t PGRAPHRoundFixed(int64_t value, uint32_t fraction_bits)
+    {
+        if (!fraction_bits)
+            return (int32_t)value;
+
+        return (int32_t)((value + (INT64_C(1) << (fraction_bits - 1))) >> fraction_bits);
+    }
+
+    // Find the tessellated patch for these control points and subdivision, tessellating it if it isn't already cached.
+    // control_beta is nullptr if the patch isn't blended
+    const NV1::PGRAPHPatchMesh& NV1::PGRAPHGetPatchMesh(uint32_t order, const int32_t control_x[NV1_PGRAPH_PATCH_MAX_POINTS], const int32_t control_y[NV1_PGRAPH_PATCH_MAX_POINTS], const int32_t* control_beta, uint32_t subdivide)
+    {
+        PGRAPHPatchMesh* oldest = &state.patch_meshes[0];
+        uint32_t points = (order + 1) * (order + 1);
+
+        state.patch_clock++;
+
+        for (PGRAPHPatchMesh& mesh : state.patch_meshes)
+        {
+            if (mesh.valid
+            && mesh.order == order
+            && mesh.subdivide == subdivide
+            && std::equal(control_x, control_x + points, mesh.control_x)
+            && std::equal(control_y, control_y + points, mesh.control_y)
+            && mesh.blended == (control_beta != nullptr)
+            && (!control_beta || std::equal(control_beta, control_beta + points, mesh.control_beta)))
+            {
+                mesh.last_used = state.patch_clock;
+                return mesh;
+            }
+
+            if (!mesh.valid
+            || (oldest->valid && mesh.last_used < oldest->last_used))
+                oldest = &mesh;
+        }
+
+        PGRAPHPatchMesh& mesh = *oldest;
+
+        mesh.order = order;
+        std::copy(control_x, control_x + points, mesh.control_x);
+        std::copy(control_y, control_y + points, mesh.control_y);
+        mesh.blended = control_beta != nullptr;
+
+        if (mesh.blended)
+            std::copy(control_beta, control_beta + points, mesh.control_beta);
+
+        mesh.subdivide = subdivide;
+        mesh.columns = 1 << PGRAPHSubdivideField(subdivide, 4);
+        mesh.rows = 1 << PGRAPHSubdivideField(subdivide, 0);
+        mesh.x.resize((mesh.columns + 1) * (mesh.rows + 1));
+        mesh.y.resize(mesh.x.size());
+        mesh.beta.resize((mesh.blended) ? mesh.columns * mesh.rows : 0);
+        mesh.last_used = state.patch_clock;
+        mesh.valid = true;
+
+        if (order == 1)
+            PGRAPHTessellatePatch<1>(mesh);
+        else
+            PGRAPHTessellatePatch<2>(mesh);
+
+        return mesh;
+    }
+
+    // Tessellate a patch. The first row of control points is the edge the texture's first row is on, so texture rows go from
+    // the 0-2 edge to the 6-8 edge (0-1 to 2-3 for bilinear patches), and columns from the 0-6 edge to the 2-8 edge.
+    // The patch is only evaluated as finely as its edges are subdivided. If the texture is finer than that, its corners are
+    // interpolated across each piece
+    template <uint32_t order> void NV1::PGRAPHTessellatePatch(PGRAPHPatchMesh& mesh)
+    {
+        constexpr uint32_t side = order + 1;
+
+        uint32_t column_texels = PGRAPHSubdivideField(mesh.subdivide, 4);
+        uint32_t row_texels = PGRAPHSubdivideField(mesh.subdivide, 0);
+        uint32_t column_level = std::min(column_texels, std::max(PGRAPHSubdivideField(mesh.subdivide, 16), PGRAPHSubdivideField(mesh.subdivide, 20)));
+        uint32_t row_level = std::min(row_texels, std::max(PGRAPHSubdivideField(mesh.subdivide, 24), PGRAPHSubdivideField(mesh.subdivide, 28)));
+        uint32_t columns = 1 << column_level;
+        uint32_t rows = 1 << row_level;
+
+        // first down each column of control points, then across each row of the result. Both are exact, so the patch comes
+        // out scaled up by (rows * columns)^order, in 12.4
+        int64_t column_x[side][NV1_PGRAPH_PATCH_MAX_SIZE + 1];
+        int64_t column_y[side][NV1_PGRAPH_PATCH_MAX_SIZE + 1];
+        int64_t row_x[NV1_PGRAPH_PATCH_MAX_SIZE + 1];
+        int64_t row_y[NV1_PGRAPH_PATCH_MAX_SIZE + 1];
+        std::vector<int32_t> vertex_x((columns + 1) * (rows + 1));
+        std::vector<int32_t> vertex_y(vertex_x.size());
+
+        for (uint32_t column = 0; column < side; column++)
+        {
+            int64_t x[side], y[side];
+
+            for (uint32_t point = 0; point < side; point++)
+            {
+                x[point] = mesh.control_x[point * side + column];
+                y[point] = mesh.control_y[point * side + column];
+            }
+
+            PGRAPHForwardDifference<order>(x, row_level, column_x[column]);
+            PGRAPHForwardDifference<order>(y, row_level, column_y[column]);
+        }
+
+        for (uint32_t row = 0; row <= rows; row++)
+        {
+            int64_t x[side], y[side];
+
+            for (uint32_t point = 0; point < side; point++)
+            {
+                x[point] = column_x[point][row];
+                y[point] = column_y[point][row];
+            }
+
+            PGRAPHForwardDifference<order>(x, column_level, row_x);
+            PGRAPHForwardDifference<order>(y, column_level, row_y);
+
+            for (uint32_t column = 0; column <= columns; column++)
+            {
+                vertex_x[row * (columns + 1) + column] = PGRAPHRoundFixed(row_x[column], order * (row_level + column_level));
+                vertex_y[row * (columns + 1) + column] = PGRAPHRoundFixed(row_y[column], order * (row_level + column_level));
+            }
+        }
+
+        // then out to every texel corner
+        uint32_t column_shift = column_texels - column_level;
+        uint32_t row_shift = row_texels - row_level;
+        int64_t column_size = 1 << column_shift;
+        int64_t row_size = 1 << row_shift;
+
+        for (uint32_t texel_row = 0; texel_row <= mesh.rows; texel_row++)
+        {
+            uint32_t row = texel_row >> row_shift;
+            int64_t row_fraction = texel_row & (row_size - 1);
+            uint32_t next_row = (row_fraction) ? row + 1 : row;
+
+            for (uint32_t texel_column = 0; texel_column <= mesh.columns; texel_column++)
+            {
+                uint32_t column = texel_column >> column_shift;
+                int64_t column_fraction = texel_column & (column_size - 1);
+                uint32_t next_column = (column_fraction) ? column + 1 : column;
+
+                uint32_t top_left = row * (columns + 1) + column;
+                uint32_t top_right = row * (columns + 1) + next_column;
+                uint32_t bottom_left = next_row * (columns + 1) + column;
+                uint32_t bottom_right = next_row * (columns + 1) + next_column;
+
+                int64_t weight_tl = (column_size - column_fraction) * (row_size - row_fraction);
+                int64_t weight_tr = column_fraction * (row_size - row_fraction);
+                int64_t weight_bl = (column_size - column_fraction) * row_fraction;
+                int64_t weight_br = column_fraction * row_fraction;
+
+                int64_t x = vertex_x[top_left] * weight_tl + vertex_x[top_right] * weight_tr + vertex_x[bottom_left] * weight_bl + vertex_x[bottom_right] * weight_br;
+                int64_t y = vertex_y[top_left] * weight_tl + vertex_y[top_right] * weight_tr + vertex_y[bottom_left] * weight_bl + vertex_y[bottom_right] * weight_br;
+
+                mesh.x[texel_row * (mesh.columns + 1) + texel_column] = PGRAPHRoundFixed(x, column_shift + row_shift + 4);
+                mesh.y[texel_row * (mesh.columns + 1) + texel_column] = PGRAPHRoundFixed(y, column_shift + row_shift + 4);
+            }
+        }
+
+        if (!mesh.blended)
+            return;
+
+        // betas are worked out at every texel corner, the same way as the positions but without anything being interpolated,
+        // and each texel gets the average of its corners
+        int64_t column_beta[side][NV1_PGRAPH_PATCH_MAX_SIZE + 1];
+        int64_t row_beta[NV1_PGRAPH_PATCH_MAX_SIZE + 1];
+        int32_t corner_beta[2][NV1_PGRAPH_PATCH_MAX_SIZE + 1];
+
+        for (uint32_t column = 0; column < side; column++)
+        {
+            int64_t beta[side];
+
+            for (uint32_t point = 0; point < side; point++)
+                beta[point] = mesh.control_beta[point * side + column];
+
+            PGRAPHForwardDifference<order>(beta, row_texels, column_beta[column]);
+        }
+
+        for (uint32_t texel_row = 0; texel_row <= mesh.rows; texel_row++)
+        {
+            int64_t beta[side];
+            int32_t* corners = corner_beta[texel_row & 1];
+            const int32_t* previous_corners = corner_beta[(texel_row - 1) & 1];
+
+            for (uint32_t point = 0; point < side; point++)
+                beta[point] = column_beta[point][texel_row];
+
+            PGRAPHForwardDifference<order>(beta, column_texels, row_beta);
+
+            for (uint32_t texel_column = 0; texel_column <= mesh.columns; texel_column++)
+                corners[texel_column] = PGRAPHRoundFixed(row_beta[texel_column], order * (row_texels + column_texels));
+
+            if (!texel_row)
+                continue;
+
+            // 1.15, and anything negative is 0
+            for (uint32_t texel_column = 0; texel_column < mesh.columns; texel_column++)
+            {
+                int64_t sum = previous_corners[texel_column] + previous_corners[texel_column + 1] + corners[texel_column] + corners[texel_column + 1];
+
+                mesh.beta[(texel_row - 1) * mesh.columns + texel_column] = std::clamp<int64_t>(PGRAPHRoundFixed(sum * NV1_PGRAPH_BETA_ONE, 17), 0, NV1_PGRAPH_BETA_ONE);
+            }
+        }
+    }
+
+    // Draw a row of texels. Each texel fills the quad between its corners, as two triangles that share the diagonal.
+    // Neighbouring texels share corners, so there are no gaps between them and nothing is drawn twice.
+    // Blended patches draw each texel with its own beta, times NV_UBETA's
+    void NV1::PGRAPHPatchRow(const PGRAPHPatchMesh& mesh, uint32_t row, const uint32_t* texels)
+    {
+        const int32_t* top_x = &mesh.x[row * (mesh.columns + 1)];
+        const int32_t* top_y = &mesh.y[row * (mesh.columns + 1)];
+        const int32_t* bottom_x = top_x + mesh.columns + 1;
+        const int32_t* bottom_y = top_y + mesh.columns + 1;
+
+        // a patch that hasn't been rotated or bent (which is what scaled sprites and video are) is a grid of rectangles.
+        // If this row is, it's a run of texels that is the same on every line
+        bool rects = true;
+        bool increasing = true;
+        bool decreasing = true;
+
+        for (uint32_t column = 0; column <= mesh.columns; column++)
+        {
+            rects &= top_y[column] == top_y[0]
+            && bottom_y[column] == bottom_y[0]
+            && top_x[column] == bottom_x[column];
+        }
+
+        for (uint32_t column = 0; column < mesh.columns; column++)
+        {
+            increasing &= top_x[column + 1] >= top_x[column];
+            decreasing &= top_x[column + 1] <= top_x[column];
+        }
+
+        if (rects
+        && (increasing || decreasing)
+        && !mesh.blended)
+        {
+            PGRAPHPatchRowRects(mesh, row, texels);
+            return;
+        }
+
+        uint32_t beta_factor = PGRAPHGetBetaFactor();
+
+        for (uint32_t column = 0; column < mesh.columns; column++)
+        {
+            int32_t first_x[3] = { top_x[column], top_x[column + 1], bottom_x[column + 1] };
+            int32_t first_y[3] = { top_y[column], top_y[column + 1], bottom_y[column + 1] };
+            int32_t second_x[3] = { top_x[column], bottom_x[column + 1], bottom_x[column] };
+            int32_t second_y[3] = { top_y[column], bottom_y[column + 1], bottom_y[column] };
+
+            if (mesh.blended)
+                pgraph.blend_beta = (mesh.beta[row * mesh.columns + column] * beta_factor) >> 8;
+
+            PGRAPHTriangle(first_x, first_y, texels[column]);
+            PGRAPHTriangle(second_x, second_y, texels[column]);
+        }
+
+        pgraph.blend_beta = NV1_PGRAPH_BETA_ONE;
+    }
+
+    // Draw a row of texels that are all axis aligned rectangles, in order along the row. The texels are expanded into one
+    // line of pixels, which is then written to every line the row covers. This draws the same pixels as the triangles would
+    void NV1::PGRAPHPatchRowRects(const PGRAPHPatchMesh& mesh, uint32_t row, const uint32_t* texels)
+    {
+        const int32_t* top_x = &mesh.x[row * (mesh.columns + 1)];
+        int32_t top_y = mesh.y[row * (mesh.columns + 1)];
+        int32_t bottom_y = mesh.y[(row + 1) * (mesh.columns + 1)];
+
+        // same as triangles
+        if (top_x[0] != (int16_t)top_x[0]
+        || top_x[mesh.columns] != (int16_t)top_x[mesh.columns]
+        || top_y != (int16_t)top_y
+        || bottom_y != (int16_t)bottom_y)
+        {
+            pgraph.exceptions |= (NV_PGRAPH_EXCEPTIONS_CLIP_XY_ONLY << 24);
+            return;
+        }
+
+        PGRAPHSurface surface = PGRAPHGetSurface();
+        PGRAPHRect bounds =
+        {
+            std::min(top_x[0], top_x[mesh.columns]), std::min(top_y, bottom_y),
+            std::max(top_x[0], top_x[mesh.columns]), std::max(top_y, bottom_y),
+        };
+
+        if (!PGRAPHClipBounds(bounds, PGRAPHGetClip(surface)))
+            return;
+
+        int32_t left = bounds.left;
+        int32_t right = bounds.right;
+        int32_t top = bounds.top;
+        int32_t bottom = bounds.bottom;
+
+        uint32_t bytes_per_pixel = surface.bytes_per_pixel;
+        PGRAPHFillSpanFn fill_span = PGRAPHGetFillSpan();
+        alignas(32) uint8_t line[NV1_PGRAPH_MAX_PITCH];
+
+        for (uint32_t column = 0; column < mesh.columns; column++)
+        {
+            int32_t texel_left = std::max(std::min(top_x[column], top_x[column + 1]), left);
+            int32_t texel_right = std::min(std::max(top_x[column], top_x[column + 1]), right);
+
+            if (texel_left < texel_right)
+                fill_span(line + (texel_left - left) * bytes_per_pixel, (texel_right - texel_left) * bytes_per_pixel, PGRAPHRepeatColor(texels[column], surface));
+        }
+
+        PGRAPHWriteMask mask = PGRAPHGetWriteMask(surface);
+
+        for (int32_t y = top; y < bottom; y++)
+            PGRAPHWriteSpan(state.video_ram8 + y * surface.pitch + left * bytes_per_pixel, line, left, y, right - left, surface, mask);
+    }
+}
@@ -0,0 +1,103 @@
+//
+// nv1_pgraph_point.cpp
+// NV1 Point Plotting
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // A point that survived clipping, and where it goes in VRAM
+    struct PGRAPHPointWrite
+    {
+        uint32_t address;
+        uint32_t color;
+        int32_t x;
+        int32_t y;
+    };
+
+    // Draw a batch of points. The surface, clip, ROP and pattern are only looked up once for the whole batch, and the
+    // points are sorted by address so that ones that are close together in VRAM get written together rather than in
+    // whatever order they came in. The sort is stable, so points on the same pixel are still drawn in order (which matters
+    // for XOR)
+    void NV1::PGRAPHPoints(std::span<const PGRAPHPoint> points)
+    {
+        PGRAPHSurface surface = PGRAPHGetSurface();
+        PGRAPHRect clip = PGRAPHGetClip(surface);
+        PGRAPHWriteMask mask = PGRAPHGetWriteMask(surface);
+        uint8_t rop = pgraph.rop3 & 0xFF;
+        bool solid = rop == NV1_ROP_SRCCOPY && !mask.active;
+        PGRAPHRop3SpanFn rop_span = PGRAPHGetRop3Span(rop);
+        const PGRAPHPatternCache* pattern_cache = PGRAPHGetRopPattern(rop, surface);
+        uint32_t bytes_per_pixel = surface.bytes_per_pixel;
+
+        PGRAPHPointWrite writes[NV1_PGRAPH_POINT_BATCH_SIZE];
+
+        while (!points.empty())
+        {
+            std::span<const PGRAPHPoint> chunk = points.first(std::min<size_t>(points.size(), NV1_PGRAPH_POINT_BATCH_SIZE));
+            uint32_t write_count = 0;
+
+            points = points.subspan(chunk.size());
+
+            for (const PGRAPHPoint& point : chunk)
+            {
+                // same as lines and triangles
+                if (point.x != (int16_t)point.x
+                || point.y != (int16_t)point.y)
+                {
+                    pgraph.exceptions |= (NV_PGRAPH_EXCEPTIONS_CLIP_XY_ONLY << 24);
+                    continue;
+                }
+
+                PGRAPHRect bounds = { point.x, point.y, point.x + 1, point.y + 1 };
+
+                if (!PGRAPHClipBounds(bounds, clip))
+                    continue;
+
+                writes[write_count++] = { point.y * surface.pitch + point.x * bytes_per_pixel, point.color, point.x, point.y };
+            }
+
+            std::stable_sort(writes, writes + write_count, [](const PGRAPHPointWrite& a, const PGRAPHPointWrite& b)
+            {
+                return a.address < b.address;
+            });
+
+            // object colours are already in the framebuffer's format, so the low bytes are the pixel
+            if (solid)
+            {
+                for (uint32_t write = 0; write < write_count; write++)
+                    memcpy(state.video_ram8 + writes[write].address, &writes[write].color, bytes_per_pixel);
+
+                continue;
+            }
+
+            for (uint32_t write = 0; write < write_count; write++)
+            {
+                uint8_t* dst = state.video_ram8 + writes[write].address;
+                uint8_t src[4], pattern[4], result[4];
+
+                memcpy(src, &writes[write].color, sizeof(src));
+
+                if (pattern_cache)
+                {
+                    // points where the pattern is transparent aren't drawn
+                    if (!pattern_cache->opaque[writes[write].y & (NV1_PGRAPH_PATTERN_SIZE - 1)][writes[write].x & (NV1_PGRAPH_PATTERN_SIZE - 1)])
+                        continue;
+
+                    PGRAPHExpandPattern(*pattern_cache, writes[write].x, writes[write].y, 1, surface, pattern);
+                }
+
+                if (!mask.active)
+                {
+                    rop_span(dst, src, pattern, bytes_per_pixel);
+                    continue;
+                }
+
+                memcpy(result, dst, bytes_per_pixel);
+                rop_span(result, src, pattern, bytes_per_pixel);
+                PGRAPHWriteSpanMasked(dst, result, src, 1, surface, mask);
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+//
+// nv1_pgraph_readback.cpp
+// NV1 Image Readback (UTOMEM)
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // Set where readbacks go. Anything still being read back into the old buffer is finished first
+    void NV1::PGRAPHSetReadbackBuffer(std::span<uint8_t> buffer)
+    {
+        PGRAPHWaitForReadback();
+        state.readback_buffer = buffer;
+    }
+
+    // Queue a readback of a rectangle of the framebuffer. This doesn't wait for it to happen
+    void NV1::PGRAPHReadback(int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t start, int32_t pitch, bool notify)
+    {
+        PGRAPHSurface surface = PGRAPHGetSurface();
+        uint32_t put = state.readback_put.load(std::memory_order_relaxed);
+        uint32_t get;
+
+        if (!state.readback_thread.joinable())
+        {
+            state.readback_running = true;
+            state.readback_asleep = false;
+            state.readback_thread = std::thread(&NV1::PGRAPHReadbackThread, this);
+        }
+
+        // the queue is full, so wait for the oldest readback
+        while (put - (get = state.readback_get.load(std::memory_order_acquire)) >= NV1_PGRAPH_READBACK_QUEUE_SIZE)
+            state.readback_get.wait(get, std::memory_order_acquire);
+
+        state.readback_queue[put % NV1_PGRAPH_READBACK_QUEUE_SIZE] = { x, y, width, height, start, pitch,
+            surface.width, surface.height, surface.pitch, surface.bytes_per_pixel, notify };
+
+        // seq_cst for the same reason as CACHE1 (see PFIFOPullerThread)
+        state.readback_put.store(put + 1, std::memory_order_seq_cst);
+
+        if (state.readback_asleep.load(std::memory_order_seq_cst))
+            PGRAPHWakeReadback();
+    }
+
+    // Wait for every queued readback to finish. Anything that draws has to do this first, or it could change the framebuffer
+    // under a readback
+    void NV1::PGRAPHWaitForReadback()
+    {
+        uint32_t put = state.readback_put.load(std::memory_order_acquire);
+        uint32_t get;
+
+        while ((get = state.readback_get.load(std::memory_order_acquire)) != put)
+            state.readback_get.wait(get, std::memory_order_acquire);
+    }
+
+    // The readback thread. Works through the queue and sleeps while it is empty
+    void NV1::PGRAPHReadbackThread()
+    {
+        while (state.readback_running.load(std::memory_order_acquire))
+        {
+            uint32_t get = state.readback_get.load(std::memory_order_relaxed);
+
+            if (get != state.readback_put.load(std::memory_order_acquire))
+            {
+                PGRAPHReadbackCopy(state.readback_queue[get % NV1_PGRAPH_READBACK_QUEUE_SIZE]);
+
+                state.readback_get.store(get + 1, std::memory_order_release);
+                state.readback_get.notify_all();
+                continue;
+            }
+
+            state.readback_asleep.store(true, std::memory_order_seq_cst);
+
+            // a readback might have been queued between checking and going to sleep
+            if (get != state.readback_put.load(std::memory_order_seq_cst))
+            {
+                state.readback_asleep.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            state.readback_asleep.wait(true, std::memory_order_acquire);
+        }
+    }
+
+    void NV1::PGRAPHWakeReadback()
+    {
+        state.readback_asleep.store(false, std::memory_order_release);
+        state.readback_asleep.notify_one();
+    }
+
+    // Copy the part of the rectangle that's inside the framebuffer into the readback buffer, at the framebuffer's depth
+    void NV1::PGRAPHReadbackCopy(const PGRAPHReadbackJob& job)
+    {
+        int32_t left = std::max(job.x, 0);
+        int32_t top = std::max(job.y, 0);
+        int32_t right = std::min(job.x + (int64_t)job.width, (int64_t)job.fb_width);
+        int32_t bottom = std::min(job.y + (int64_t)job.height, (int64_t)job.fb_height);
+
+        if (left < right
+        && top < bottom)
+        {
+            uint32_t bytes = (right - left) * job.bytes_per_pixel;
+            const uint8_t* src = state.video_ram8 + top * job.fb_pitch + left * job.bytes_per_pixel;
+
+            for (int32_t line = top; line < bottom; line++, src += job.fb_pitch)
+            {
+                int64_t offset = job.start + (int64_t)(line - job.y) * job.pitch + (int64_t)(left - job.x) * job.bytes_per_pixel;
+
+                if (offset < 0
+                || (uint64_t)offset + bytes > state.readback_buffer.size())
+                {
+                    Logging_LogChannel("UTOMEM: Line %d of readback goes outside the readback buffer", LogChannel::Debug, line - job.y);
+                    continue;
+                }
+
+                memcpy(state.readback_buffer.data() + offset, src, bytes);
+            }
+        }
+
+        // INTR_0 belongs to the main thread, which picks this up the next time it updates interrupts
+        if (job.notify)
+            state.readback_notify.store(true, std::memory_order_release);
+    }
+}
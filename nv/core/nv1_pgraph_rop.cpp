@@ -0,0 +1,114 @@
+//
+// nv1_pgraph_rop.cpp
+// NV1 Raster Operations
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // 16 bytes at a time. The compiler turns operations on these into whatever vector instructions the host has
+    typedef uint8_t PGRAPHRopVector __attribute__((vector_size(16)));
+
+    // A ROP3 is a truth table indexed by (pattern << 2) | (source << 1) | destination.
+    // Rather than OR together all eight minterms, split the table on one input at a time so each ROP ends up as the handful of
+    // bitwise operations it really is (e.g. 0x66 is just S ^ D)
+
+    // Function of D alone, 2-entry truth table
+    template <uint32_t table, typename T> static inline T PGRAPHRopD(T d)
+    {
+        if constexpr (table == 0)
+            return T{};
+        else if constexpr (table == 1)
+            return ~d;
+        else if constexpr (table == 2)
+            return d;
+        else
+            return ~T{};
+    }
+
+    // Function of S and D, 4-entry truth table. Each half is a function of D
+    template <uint32_t table, typename T> static inline T PGRAPHRopSD(T s, T d)
+    {
+        constexpr uint32_t low = table & 0x03;      // S = 0
+        constexpr uint32_t high = table >> 2;       // S = 1
+
+        if constexpr (low == high)
+            return PGRAPHRopD<low>(d);
+        else if constexpr (low == 0)
+            return s & PGRAPHRopD<high>(d);
+        else if constexpr (high == 0)
+            return ~s & PGRAPHRopD<low>(d);
+        else if constexpr ((low ^ high) == 0x03)
+            return s ^ PGRAPHRopD<low>(d);
+        else
+            return (s & PGRAPHRopD<high>(d)) | (~s & PGRAPHRopD<low>(d));
+    }
+
+    // The full ROP3. Each half is a function of S and D
+    template <uint32_t rop, typename T> static inline T PGRAPHRop3(T p, T s, T d)
+    {
+        constexpr uint32_t low = rop & 0x0F;        // P = 0
+        constexpr uint32_t high = rop >> 4;         // P = 1
+
+        if constexpr (low == high)
+            return PGRAPHRopSD<low>(s, d);
+        else if constexpr (low == 0)
+            return p & PGRAPHRopSD<high>(s, d);
+        else if constexpr (high == 0)
+            return ~p & PGRAPHRopSD<low>(s, d);
+        else if constexpr ((low ^ high) == 0x0F)
+            return p ^ PGRAPHRopSD<low>(s, d);
+        else
+            return (p & PGRAPHRopSD<high>(s, d)) | (~p & PGRAPHRopSD<low>(s, d));
+    }
+
+    template <uint32_t rop> static void PGRAPHRop3Span(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes)
+    {
+        for (; bytes >= sizeof(PGRAPHRopVector); bytes -= sizeof(PGRAPHRopVector))
+        {
+            PGRAPHRopVector p, s, d;
+
+            memcpy(&p, pattern, sizeof(p));
+            memcpy(&s, src, sizeof(s));
+            memcpy(&d, dst, sizeof(d));
+
+            d = PGRAPHRop3<rop>(p, s, d);
+            memcpy(dst, &d, sizeof(d));
+
+            dst += sizeof(PGRAPHRopVector);
+            src += sizeof(PGRAPHRopVector);
+            pattern += sizeof(PGRAPHRopVector);
+        }
+
+        for (; bytes; bytes--, dst++, src++, pattern++)
+            *dst = PGRAPHRop3<rop, uint8_t>(*pattern, *src, *dst);
+    }
+
+    // These are most of what GDI does, so they are straight copies
+    template <> void PGRAPHRop3Span<NV1_ROP_SRCCOPY>(uint8_t* dst, const uint8_t* src, const uint8_t* /*pattern*/, uint32_t bytes)
+    {
+        memmove(dst, src, bytes);
+    }
+
+    template <> void PGRAPHRop3Span<NV1_ROP_PATCOPY>(uint8_t* dst, const uint8_t* /*src*/, const uint8_t* pattern, uint32_t bytes)
+    {
+        memcpy(dst, pattern, bytes);
+    }
+
+    // dst is already the result
+    template <> void PGRAPHRop3Span<NV1_ROP_DSTCOPY>(uint8_t* /*dst*/, const uint8_t* /*src*/, const uint8_t* /*pattern*/, uint32_t /*bytes*/) { }
+
+    template <size_t... rops> static constexpr std::array<NV1::PGRAPHRop3SpanFn, 256> PGRAPHMakeRop3Spans(std::index_sequence<rops...>)
+    {
+        return { &PGRAPHRop3Span<rops>... };
+    }
+
+    static constexpr std::array<NV1::PGRAPHRop3SpanFn, 256> pgraph_rop3_spans = PGRAPHMakeRop3Spans(std::make_index_sequence<256>());
+
+    // Get the span function for a ROP. Look this up once per primitive, not per span
+    NV1::PGRAPHRop3SpanFn NV1::PGRAPHGetRop3Span(uint8_t rop)
+    {
+        return pgraph_rop3_spans[rop];
+    }
+}
@@ -0,0 +1,184 @@
+//
+// nv1_pgraph_tri.cpp
+// NV1 Triangle Rasterisation
+//
+
+#include <nv/nv1.hpp>
+
+namespace NV1Sim
+{
+    // Compare one side of a triangle's extent with the clip rectangle, as an NV_PGRAPH_EDGEFILL field
+    static inline uint32_t PGRAPHEdgefillCompare(int32_t value, int32_t limit, uint32_t less, uint32_t greater)
+    {
+        if (value == limit)
+            return NV_PGRAPH_EDGEFILL_X16_MIN_EQ;
+
+        return (value < limit) ? less : greater;
+    }
+
+    // Draw a flat triangle. Vertices are on pixel corners, and a pixel is drawn if its centre is inside.
+    // Pixels exactly on an edge belong to the triangle on the top or left of it, so triangles that share an edge don't overlap
+    void NV1::PGRAPHTriangle(const int32_t x[3], const int32_t y[3], uint32_t color)
+    {
+        // the rasteriser only has 16 bits of position, software has to split up anything bigger
+        for (uint32_t vertex = 0; vertex < 3; vertex++)
+        {
+            if (x[vertex] != (int16_t)x[vertex]
+            || y[vertex] != (int16_t)y[vertex])
+            {
+                pgraph.exceptions |= (NV_PGRAPH_EXCEPTIONS_CLIP_XY_ONLY << 24);
+                return;
+            }
+        }
+
+        int64_t area = (int64_t)(x[1] - x[0]) * (y[2] - y[0]) - (int64_t)(y[1] - y[0]) * (x[2] - x[0]);
+
+        // nothing is inside a triangle with no area
+        if (!area)
+            return;
+
+        PGRAPHTriangleSetup setup;
+        setup.surface = PGRAPHGetSurface();
+
+        PGRAPHRect clip = PGRAPHGetClip(setup.surface);
+        PGRAPHRect extent =
+        {
+            std::min({ x[0], x[1], x[2] }), std::min({ y[0], y[1], y[2] }),
+            std::max({ x[0], x[1], x[2] }), std::max({ y[0], y[1], y[2] }),
+        };
+
+        // how the triangle compares to the clip rectangle, for anything that traps on it
+        uint32_t edgefill = PGRAPHEdgefillCompare(extent.left, clip.left, NV_PGRAPH_EDGEFILL_X16_MIN_LT, NV_PGRAPH_EDGEFILL_X16_MIN_GT)
+        | (PGRAPHEdgefillCompare(extent.right, clip.right, NV_PGRAPH_EDGEFILL_X16_MAX_LT, NV_PGRAPH_EDGEFILL_X16_MAX_GT) << 2)
+        | (PGRAPHEdgefillCompare(extent.top, clip.top, NV_PGRAPH_EDGEFILL_Y16_MIN_LT, NV_PGRAPH_EDGEFILL_Y16_MIN_GT) << 4)
+        | (PGRAPHEdgefillCompare(extent.bottom, clip.bottom, NV_PGRAPH_EDGEFILL_Y16_MAX_LT, NV_PGRAPH_EDGEFILL_Y16_MAX_GT) << 6);
+
+        pgraph.edgefill = (pgraph.edgefill & ~0x00FF0000) | (edgefill << 16);
+
+        setup.bounds = extent;
+
+        if (!PGRAPHClipBounds(setup.bounds, clip))
+            return;
+
+        // wind the triangle so that the inside of every edge is positive
+        uint32_t order[3] = { 0, 1, 2 };
+
+        if (area < 0)
+            std::swap(order[1], order[2]);
+
+        for (uint32_t edge = 0; edge < 3; edge++)
+        {
+            uint32_t from = order[edge];
+            uint32_t to = order[(edge + 1) % 3];
+            int64_t dx = 2 * (int64_t)(x[to] - x[from]);
+            int64_t dy = 2 * (int64_t)(y[to] - y[from]);
+
+            setup.edge_a[edge] = -dy;
+            setup.edge_b[edge] = dx;
+            setup.edge_c[edge] = dy * 2 * x[from] - dx * 2 * y[from];
+
+            // left edges have the inside to the right, top edges have it below
+            bool top_left = (setup.edge_a[edge] > 0)
+            || (setup.edge_a[edge] == 0 && setup.edge_b[edge] > 0);
+
+            setup.threshold[edge] = (top_left) ? 0 : 1;
+        }
+
+        uint8_t rop = pgraph.rop3 & 0xFF;
+
+        setup.mask = PGRAPHGetWriteMask(setup.surface);
+        setup.pattern = PGRAPHRepeatColor(color, setup.surface);
+        setup.solid = rop == NV1_ROP_SRCCOPY && !setup.mask.active;
+        setup.fill_span = PGRAPHGetFillSpan();
+        setup.rop_span = PGRAPHGetRop3Span(rop);
+        setup.pattern_cache = PGRAPHGetRopPattern(rop, setup.surface);
+
+        if (!setup.solid)
+            setup.fill_span(setup.color_row, (setup.bounds.right - setup.bounds.left) * setup.surface.bytes_per_pixel, setup.pattern);
+
+        // bin the triangle into the tiles that its bounding box touches. Tiles are aligned to the screen, not to the triangle
+        for (int32_t tile_y = setup.bounds.top & ~(NV1_PGRAPH_TILE_SIZE - 1); tile_y < setup.bounds.bottom; tile_y += NV1_PGRAPH_TILE_SIZE)
+        {
+            for (int32_t tile_x = setup.bounds.left & ~(NV1_PGRAPH_TILE_SIZE - 1); tile_x < setup.bounds.right; tile_x += NV1_PGRAPH_TILE_SIZE)
+            {
+                PGRAPHRect tile =
+                {
+                    std::max(tile_x, setup.bounds.left), std::max(tile_y, setup.bounds.top),
+                    std::min(tile_x + NV1_PGRAPH_TILE_SIZE, setup.bounds.right), std::min(tile_y + NV1_PGRAPH_TILE_SIZE, setup.bounds.bottom),
+                };
+
+                PGRAPHTriangleTile(setup, tile);
+            }
+        }
+    }
+
+    // Rasterise the part of a triangle that is inside one tile. This only writes pixels inside the tile and only reads the
+    // setup and the tile's own pixels, so tiles can be given to different threads
+    void NV1::PGRAPHTriangleTile(const PGRAPHTriangleSetup& setup, const PGRAPHRect& tile)
+    {
+        bool full = true;
+
+        // test the centres of the tile's corner pixels against each edge. The edges are straight, so if every corner is
+        // outside one of them the whole tile is, and if every corner is inside all of them the whole tile is
+        for (uint32_t edge = 0; edge < 3; edge++)
+        {
+            int64_t a = setup.edge_a[edge];
+            int64_t b = setup.edge_b[edge];
+            int64_t left = a * (2 * tile.left + 1);
+            int64_t right = a * (2 * tile.right - 1);
+            int64_t top = b * (2 * tile.top + 1) + setup.edge_c[edge];
+            int64_t bottom = b * (2 * tile.bottom - 1) + setup.edge_c[edge];
+
+            int64_t min = std::min(left, right) + std::min(top, bottom);
+            int64_t max = std::max(left, right) + std::max(top, bottom);
+
+            if (max < setup.threshold[edge])
+                return;
+
+            if (min < setup.threshold[edge])
+                full = false;
+        }
+
+        const PGRAPHSurface& surface = setup.surface;
+        uint32_t bytes_per_pixel = surface.bytes_per_pixel;
+
+        for (int32_t line = tile.top; line < tile.bottom; line++)
+        {
+            int64_t left = tile.left;
+            int64_t right = tile.right;
+
+            // where each edge crosses the centre of this line. E = 2a * x + (a + b * (2y + 1) + c) at the centre of pixel x
+            if (!full)
+            {
+                for (uint32_t edge = 0; edge < 3; edge++)
+                {
+                    int64_t step = 2 * setup.edge_a[edge];
+                    int64_t start = setup.edge_a[edge] + setup.edge_b[edge] * (2 * line + 1) + setup.edge_c[edge];
+                    int64_t threshold = setup.threshold[edge];
+
+                    if (step > 0)
+                        left = std::max(left, Util_CeilDiv(threshold - start, step));
+                    else if (step < 0)
+                        right = std::min(right, Util_FloorDiv(start - threshold, -step) + 1);
+                    else if (start < threshold)
+                        right = left;
+                }
+            }
+
+            if (left >= right)
+                continue;
+
+            uint8_t* dst = state.video_ram8 + line * surface.pitch + left * bytes_per_pixel;
+            uint32_t pixels = right - left;
+            uint32_t bytes = pixels * bytes_per_pixel;
+
+            if (setup.solid)
+            {
+                setup.fill_span(dst, bytes, setup.pattern);
+                continue;
+            }
+
+            PGRAPHWriteSpanRop(dst, setup.color_row, left, line, pixels, surface, setup.mask, setup.rop_span, setup.pattern_cache);
+        }
+    }
+}
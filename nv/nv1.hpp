@@ -31,8 +31,11 @@ namespace NV1Sim
     {
         uint32_t vram_amount; 
         uint32_t straps;
+        bool pfifo_thread;                  // Run the PFIFO puller and PGRAPH on their own thread
     }; 
 
+    class NV1UBase;
+
     // The main class, where everything cool happens.
     class NV1
     {
@@ -41,6 +44,84 @@ namespace NV1Sim
         typedef uint32_t (NV1::*GpuReadRegFn)(); 
         typedef void (NV1::*GpuWriteRegFn)(uint32_t value);
 
+        // A UTOMEM readback waiting for the readback thread. The framebuffer layout is taken when it's queued
+        #define NV1_PGRAPH_READBACK_QUEUE_SIZE  16
+
+        struct PGRAPHReadbackJob
+        {
+            int32_t x;
+            int32_t y;
+            uint32_t width;
+            uint32_t height;
+            uint32_t start;                 // Offset into the readback buffer
+            int32_t pitch;                  // Bytes between lines in the readback buffer
+            uint32_t fb_width;
+            uint32_t fb_height;
+            uint32_t fb_pitch;
+            uint32_t bytes_per_pixel;
+            bool notify;                    // Raise NV_PGRAPH_INTR_0_NOTIFY when done
+        };
+
+        // A texture patch, tessellated into the screen position of every texel corner. This is a lot of work for a big texture,
+        // and software tends to draw the same patches every frame, so the last few are kept
+        #define NV1_PGRAPH_PATCH_CACHE_SIZE     4
+        #define NV1_PGRAPH_PATCH_MAX_POINTS     9       // 3x3 for quadratic patches, 2x2 for bilinear ones
+        #define NV1_PGRAPH_PATCH_MAX_SIZE       256     // Texels along either side of the texture
+
+        struct PGRAPHPatchMesh
+        {
+            bool valid = false;
+            uint32_t order;                 // 1 for bilinear patches, 2 for quadratic ones
+            int32_t control_x[NV1_PGRAPH_PATCH_MAX_POINTS];     // 12.4, as sent
+            int32_t control_y[NV1_PGRAPH_PATCH_MAX_POINTS];
+            bool blended;                   // Each control point has a beta, and so does each texel
+            int32_t control_beta[NV1_PGRAPH_PATCH_MAX_POINTS];  // 1.15
+            uint32_t subdivide;             // NV_PGRAPH_SUBDIVIDE when it was tessellated
+            uint32_t columns;               // Texels in each row of the texture
+            uint32_t rows;
+            std::vector<int32_t> x;         // (columns + 1) * (rows + 1) texel corners, in pixels
+            std::vector<int32_t> y;
+            std::vector<uint16_t> beta;     // columns * rows texel betas, out of 256, if the patch is blended
+            uint32_t last_used;             // The least recently used mesh is the one that gets replaced
+        };
+
+        // The pattern, expanded into pixels at the framebuffer's depth so that spans of it can just be copied. Every shape repeats
+        // within 64 pixels across, and each row holds two repeats so that a span can be copied from any point in the pattern
+        #define NV1_PGRAPH_PATTERN_SIZE         64
+
+        struct PGRAPHPatternCache
+        {
+            bool valid = false;
+            uint32_t shape;                 // The registers it was expanded from. The driver can write them directly, not
+            uint32_t bitmap[NV_PGRAPH_PATTERN__SIZE_1];     // just through NV_UPATT, so they are compared rather than trusted
+            uint32_t color_0;
+            uint32_t color_1;
+            uint32_t alpha_0;
+            uint32_t alpha_1;
+            uint32_t bytes_per_pixel;
+            bool transparent;               // Some of the pattern is transparent, so drawing through it has to skip those pixels
+            alignas(32) uint8_t rows[NV1_PGRAPH_PATTERN_SIZE][NV1_PGRAPH_PATTERN_SIZE * 2 * 4];
+            uint8_t opaque[NV1_PGRAPH_PATTERN_SIZE][NV1_PGRAPH_PATTERN_SIZE];
+        };
+
+        // Where drawing is allowed, which is where the surface, canvas, clip 0 and the user clip rectangle overlap. The clip
+        // registers change far less often than anything is drawn, so this is only worked out again when one of them changes.
+        // Every primitive is clipped against it once, when it's set up
+        #define NV1_PGRAPH_CLIP_REGISTERS       9
+
+        struct PGRAPHClipState
+        {
+            bool valid = false;
+            uint32_t registers[NV1_PGRAPH_CLIP_REGISTERS];  // What it was worked out from
+            int32_t left;
+            int32_t top;
+            int32_t right;
+            int32_t bottom;
+            std::atomic<uint64_t> accepted = 0;     // Primitives that were entirely inside
+            std::atomic<uint64_t> trimmed = 0;      // Primitives that were partly inside, and were cut down to fit
+            std::atomic<uint64_t> rejected = 0;     // Primitives that were entirely outside, and weren't drawn at all
+        };
+
         // The state of the NV1
         struct GPUState
         {
@@ -49,17 +130,44 @@ namespace NV1Sim
             uint32_t* video_ram32;          // Video RAM (32-bit addressing)
             uint16_t* video_ram16;          // Video RAM (16-bit addressing)
             uint8_t* video_ram8;            // Video RAM (8-bit addressing)
+
+            // Puller thread (GPUSettings::pfifo_thread)
+            std::thread puller_thread;
+            std::atomic<bool> puller_running;   // Cleared to make the puller thread exit
+            std::atomic<bool> puller_asleep;    // Set by the puller when CACHE1 is empty, cleared by whoever wakes it
+            std::atomic<bool> pusher_waiting;   // Set while a run of methods waits for room in CACHE1
+
+            // Readback thread (UTOMEM). Started by the first readback. PGRAPH is the only thing that queues readbacks
+            std::thread readback_thread;
+            std::atomic<bool> readback_running;
+            std::atomic<bool> readback_asleep;
+            std::atomic<uint32_t> readback_get;
+            std::atomic<uint32_t> readback_put;
+            PGRAPHReadbackJob readback_queue[NV1_PGRAPH_READBACK_QUEUE_SIZE];
+            std::span<uint8_t> readback_buffer; // Provided by the host
+            std::atomic<bool> readback_notify;  // A readback asked for a notify. Folded into PGRAPH INTR_0 by FirePendingInterrupts
+
+            // Tessellated texture patches
+            PGRAPHPatchMesh patch_meshes[NV1_PGRAPH_PATCH_CACHE_SIZE];
+            uint32_t patch_clock = 0;
+
+            // The current pattern
+            PGRAPHPatternCache pattern;
+
+            // The clip rectangle, and how much primitives have been clipped by it
+            PGRAPHClipState clip;
         };
 
         // Master Control 
         struct PMC
         {
             uint32_t boot;                  // Boot configuration register
+            uint32_t debug_0;
             uint32_t intr;                  // Interrupt status
             uint32_t intr_en;               // Master Interrupt Enable
             uint32_t intr_read;             // Interrupt Read
             uint32_t enable;                // Master GPU Control
-
+            uint32_t watchdog;
         };
 
 
@@ -86,8 +194,6 @@ namespace NV1Sim
             uint32_t pull0;                         // bit8 - hw/sw device; bit4 - ramht hash generation success indicator; bit0-access enabled
             uint32_t pull1;                         // bit8 - object changed; bit4 - context clean/dity; bit2:0 - subchannel [0-7]
             uint32_t status;
-            uint32_t get_address;
-            uint32_t put_address;
             uint32_t context[NV_PFIFO_CACHE1_CTX__SIZE_1];
 
 
@@ -96,20 +202,28 @@ namespace NV1Sim
         struct PFIFOCache0
         {
             PFIFOCacheBase cache_data;
+            uint32_t get_address;
+            uint32_t put_address;
         };
 
+        #define NV1_CACHE1_SIZE                 NV_PFIFO_CACHE1_METHOD__SIZE_1
+        #define NV1_CACHE1_MASK                 (NV1_CACHE1_SIZE - 1)
+
+        // CACHE1 is a ring over PFIFO::cache1_data with one producer (USER space writes) and one consumer (the puller), so it needs no locks.
+        // GET and PUT are kept in binary. The hardware uses gray code, but that is only produced when they are accessed over MMIO
         struct PFIFOCache1
         {
             PFIFOCacheBase cache_data;
+            std::atomic<uint32_t> get_address = 0;  // Only written by the puller
+            std::atomic<uint32_t> put_address = 0;  // Only written by the pusher
 
-            // Get free spaces (cache1 only)
+            // Get free spaces (cache1 only). One entry is always kept free so a full cache can be told apart from an empty one
             uint32_t GetFreeSpaces()
             {
-                // convert to slot number
-                uint8_t binary_get_address = Util_Gray2Binary(cache_data.get_address) << 2;
-                uint8_t binary_put_address = Util_Gray2Binary(cache_data.put_address) << 2;
+                uint32_t binary_get_address = get_address.load(std::memory_order_acquire);
+                uint32_t binary_put_address = put_address.load(std::memory_order_relaxed);
 
-                return (binary_get_address - binary_put_address - 4) & 0x7C; //GUARANTEED fifo depth
+                return ((binary_get_address - binary_put_address - 1) & NV1_CACHE1_MASK) << 2; //GUARANTEED fifo depth
             }
         };
 
@@ -120,9 +234,47 @@ namespace NV1Sim
             uint32_t param;                         // Parameter for the object method
         };
 
+        #define NV1_RAMHT_ENTRY_SIZE            8
+        #define NV1_RAMHT_CACHE_SIZE            256
+
+        // A RAMHT lookup that was already done
+        struct RAMHTCacheEntry
+        {
+            uint32_t handle;
+            uint32_t channel;
+            uint32_t context;                       // Second dword of the RAMHT entry (instance, device, channel)
+            uint32_t generation;                    // Only valid if this matches RAMHTCache::generation
+        };
+
+        // Software cache of RAMHT lookups, so switching between the same objects doesn't walk RAMHT in VRAM every time.
+        // Only the puller looks things up. Any write into RAMHT (or a new RAMIN layout) bumps the generation, which invalidates everything
+        struct RAMHTCache
+        {
+            RAMHTCacheEntry entries[NV1_RAMHT_CACHE_SIZE] = { };
+            std::atomic<uint32_t> generation = 1;
+            std::atomic<uint64_t> hits = 0;
+            std::atomic<uint64_t> misses = 0;
+        };
+
+        #define NV1_CHANNELS                    128
+        #define NV1_CHANNEL_MASK                (NV1_CHANNELS - 1)
+        #define NV1_RAMFC_ENTRY_SIZE            (NV_PFIFO_CACHE1_CTX__SIZE_1 * 4)
+
+        // CACHE1 state of a channel that doesn't currently own CACHE1. On hardware this is saved to and restored from RAMFC on every 
+        // channel switch; we keep it here instead, so a switch never touches VRAM, and only write it back when RAMFC is actually accessed
+        struct PFIFOChannelContext
+        {
+            uint32_t context[NV_PFIFO_CACHE1_CTX__SIZE_1];
+            uint32_t pull1;                         // Current subchannel and object changed bit
+            bool valid;                             // Not loaded from RAMFC yet if false
+            bool dirty;                             // Newer than the copy in RAMFC
+        };
+
         // I/O Architecture & Submission 
         struct PFIFO
         {
+            uint32_t delay_0;
+            uint32_t debug_0;
             uint32_t intr;                          // Interrupt status
             uint32_t intr_en;                       // Master Interrupt Enable
             uint32_t config;
@@ -135,8 +287,69 @@ namespace NV1Sim
             uint32_t runout_status;
             uint32_t runout_get_address;
             uint32_t runout_put_address;
+            std::atomic<uint64_t> runout_entries = 0;       // Methods that went to RAMRO
+            std::atomic<uint64_t> runout_overflows = 0;     // Methods lost because RAMRO was full too
+
+            uint32_t device[NV_PFIFO_DEVICE__SIZE_1];   // Channel ID and switch availability for each device
+
+            RAMHTCache ramht_cache;
+            PFIFOChannelContext channel_contexts[NV1_CHANNELS] = { };
         }; 
 
+        // DMA engine (resource manager, audio and graphics DMA channels)
+        struct PDMA
+        {
+            uint32_t rm_intr;
+            uint32_t au_intr;
+            uint32_t gr_intr;
+            uint32_t rm_intr_en;
+            uint32_t au_intr_en;
+            uint32_t gr_intr_en;
+
+            uint32_t au_control;
+            uint32_t gr_control;
+            uint32_t au_limit;
+            uint32_t gr_limit;
+            uint32_t au_tlb_pte;
+            uint32_t gr_tlb_pte;
+            uint32_t au_tlb_tag;
+            uint32_t gr_tlb_tag;
+            uint32_t au_channel;
+            uint32_t gr_channel;
+            uint32_t rm_status_0;
+            uint32_t au_status_0;
+            uint32_t gr_status_0;
+            uint32_t au_status_1;
+            uint32_t gr_status_1;
+            uint32_t au_adj_offset;
+            uint32_t gr_adj_offset;
+            uint32_t rm_phy_start;
+            uint32_t au_phy_start;
+            uint32_t gr_phy_start;
+
+            uint32_t rm_buff_out[NV_PDMA_RM_BUFF_OUT__SIZE_1];
+            uint32_t au_buff_out[NV_PDMA_AU_BUFF_OUT__SIZE_1];
+            uint32_t gr_buff_out[NV_PDMA_GR_BUFF_OUT__SIZE_1];
+            uint32_t buff_in[NV_PDMA_BUFF_IN__SIZE_1];
+
+            uint32_t au_instance;
+            uint32_t gr_instance;
+            uint32_t au_offset;
+            uint32_t gr_offset;
+            uint32_t au_out32;
+            uint32_t gr_out32;
+            uint32_t rm_flush32;
+            uint32_t au_flush32;
+            uint32_t gr_flush32;
+            uint32_t au_flush_buff;
+            uint32_t gr_flush_buff;
+            uint32_t rm_in;
+            uint32_t au_in;
+            uint32_t gr_in;
+            uint32_t au_notify;
+            uint32_t gr_notify;
+        };
+
         // Framebuffer interface & control
         struct PFB
         {
@@ -144,6 +357,22 @@ namespace NV1Sim
             uint32_t intr;                  // Interrupt status
             uint32_t intr_en;               // Master Interrupt Enable
             uint32_t config;                // Configuration 
+            uint32_t config_1;
+            uint32_t delay_0;
+            uint32_t delay_1;
+            uint32_t debug_0;
+            uint32_t green;                 // Power saving
+            uint32_t start;                 // Scanout start address
+
+            // CRTC timings
+            uint32_t hor_frnt_porch;
+            uint32_t hor_sync_width;
+            uint32_t hor_back_porch;
+            uint32_t hor_disp_width;
+            uint32_t ver_frnt_porch;
+            uint32_t ver_sync_width;
+            uint32_t ver_back_porch;
+            uint32_t ver_disp_width;
         };
 
         // Bus Interface
@@ -153,6 +382,11 @@ namespace NV1Sim
         }; 
 
         // 2D & 3D Rendering Engine ("BPORT" probably not needed)
+        #define NV1_PGRAPH_NUM_CLASSES          128
+
+        // Betas are worked out as a fraction of 256
+        #define NV1_PGRAPH_BETA_ONE             256
+
         struct PGRAPH
         {
             uint32_t debug_0;
@@ -170,25 +404,27 @@ namespace NV1Sim
             uint32_t trapped_addr;
             uint32_t trapped_data;
             uint32_t canvas_misc;
-            uint32_t clip0_min;             // 31:16 - y, 15:0 - x
-            uint32_t clip0_max;             // 31:16 - y, 15:0 - x
+            uint32_t canvas_min;            // 31:16 - y, 15:0 - x
+            uint32_t canvas_max;            // 27:16 - y, 11:0 - x
+            uint32_t clip0_min;             // 27:16 - y, 11:0 - x
+            uint32_t clip0_max;             // 27:16 - y, 11:0 - x
             uint32_t clip1_min;             // 31:16 - y, 15:0 - x
             uint32_t clip1_max;             // 31:16 - y, 15:0 - x
             uint32_t clip_misc;
             uint32_t notify;
-            // do we need DMA register? in effect all dma registers are contiguous!
+            uint32_t dma;                   // in effect all dma registers are contiguous!
 
             // pattern shit (slightly renamed frrom original NV registers)
             uint32_t patt_0_rgb;
             uint32_t patt_0_a;
             uint32_t patt_1_rgb;
             uint32_t patt_1_a;
-            uint32_t pattern_bitmap_high;   // 63:32 
-            uint32_t pattern_bitmap_low;    // 31:0
+            uint32_t pattern_bitmap[NV_PGRAPH_PATTERN__SIZE_1];    // 0 - 31:0; 1 - 63:32
             uint32_t pattern_shape;         // 0 - 8x8; 1 - 64x1; 2 - 1x64
             uint32_t mono_color0;           // colour expanded bitblit
             uint32_t mono_color1;           // colour expanded bitblit
             uint32_t rop3;                  // GDI ROP3
+            uint32_t plane_mask;
             uint32_t chroma_key;            // Colour Key for Operations
             uint32_t beta;                  // Beta factor for blending
 
@@ -196,6 +432,7 @@ namespace NV1Sim
             uint32_t abs_x_ram[NV_PGRAPH_XY_LOGIC_RAM_SIZE]; // absolute
             uint32_t rel_x_ram[NV_PGRAPH_XY_LOGIC_RAM_SIZE]; // relative
             uint32_t x_ram[NV_PGRAPH_XY_LOGIC_RAM_SIZE];
+            uint32_t y_ram[NV_PGRAPH_XY_LOGIC_RAM_SIZE];
             uint32_t rel_y_ram[NV_PGRAPH_XY_LOGIC_RAM_SIZE];
             uint32_t abs_y_ram[NV_PGRAPH_XY_LOGIC_RAM_SIZE];
 
@@ -227,13 +464,40 @@ namespace NV1Sim
             uint32_t beta_factor_ram[NV_PGRAPH_BETA_RAM__SIZE_1];
             uint32_t bit33;         // overflow
 
+            NV1UBase* classes[NV1_PGRAPH_NUM_CLASSES] = { };  // One of each graphics class, indexed by class ID
+            NV1UBase* batch_object = nullptr;                   // Class that has primitives queued up that haven't been drawn yet
+            uint32_t blend_beta = NV1_PGRAPH_BETA_ONE;          // Beta of the primitive being drawn. Only beta classes draw anything less than 1
         };
 
         // Audio engine
         struct PAUDIO
         {
+            uint32_t green;                 // Power saving
             uint32_t intr;                  // Interrupt status
+            uint32_t intr_1;                // Interrupt status
             uint32_t intr_en;               // Master Interrupt Enable
+            uint32_t intr_en_1;             // Master Interrupt Enable
+            uint32_t context;
+
+            uint32_t block_new;
+            uint32_t block_engine;
+            uint32_t block_pump;
+            uint32_t near_mark;
+            uint32_t sample_count;
+            uint32_t termination;
+            uint32_t usage;
+
+            uint32_t codec[NV_PAUDIO_CODEC__SIZE_1];
+            uint32_t cache_analog;
+            uint32_t cache_input;
+            uint32_t cache_output;
+            uint32_t fetch[NV_PAUDIO_FETCH__SIZE_1];
+            uint32_t time_return[NV_PAUDIO_TIME_RETURN__SIZE_1];
+            uint32_t header[NV_PAUDIO_HEADER__SIZE_1];
+
+            uint32_t root_input;
+            uint32_t root_output;
+            uint32_t root_note;
         };
 
         // DRM & Authentication Engine
@@ -249,6 +513,9 @@ namespace NV1Sim
             uint32_t intr_en;               // Master Interrupt Enable
             uint32_t numerator;
             uint32_t denominator;
+            uint32_t time_0;                // 31:5 - nanoseconds
+            uint32_t time_1;                // 28:0 - nanoseconds (high)
+            uint32_t alarm;
         };
 
         // RAMIN config
@@ -267,6 +534,9 @@ namespace NV1Sim
             uint32_t ramau_size;
             uint32_t rampw_start;
             uint32_t rampw_size;    
+
+            uint32_t hash_virtual[NV_PRAM_HASH_VIRTUAL__SIZE_1];   // Handles to hash
+            uint32_t hash_physical;                                 // Result of the last hash
         };
 
         // Move to private cpp file?
@@ -314,6 +584,7 @@ namespace NV1Sim
         PMC pmc;                                // Master control
         PRM prm;                                // Real-mode I/O
         PFIFO pfifo;                            // FIFO for object submission
+        PDMA pdma;                              // DMA engine
         PFB pfb;                                // Framebuffer Interface
         PBUS pbus;                              // Bus
         PGRAPH pgraph;                          // 2D/3D Graphics
@@ -330,8 +601,8 @@ namespace NV1Sim
 
         struct NV1Mapping
         {
-            uint32_t* reg;
-
+            uint32_t addr;
+            uint32_t reg;           // offset of the backing store within the NV1 (see NV1_REG)
 
             uint32_t (NV1::*read_func)();
             void (NV1::*write_func)(uint32_t value);
@@ -339,162 +610,283 @@ namespace NV1Sim
             const char* description;
             uint32_t end;           // optional for multigpu
 
-            // THESE MUST BE THE LAST ELEMENT DUE TO PROGRAMMING TERRORISM THAT WE DID!
-            uint32_t real_ptr = 0xFFFFFFFF;
-            uint32_t index = 0; 
+            // Array registers only
+            uint32_t stride = 0;        // distance between elements in MMIO space
+            uint32_t reg_stride = 0;    // distance between elements in the backing store
         };
 
-        // nearly every register is 32bit so we can get away with this 
-        // we don't bother emulating the DAC, because the "DAC" is basically SDL
-        std::unordered_map<uint32_t, NV1Mapping> mappings32 =
-        {
-            // PMC
-            { NV_PMC_BOOT_0, { &this->pmc.boot, nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER } }, 
-            { NV_PMC_INTR_0, { &this->pmc.intr, nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER } },
-            { NV_PMC_INTR_EN_0, { &this->pmc.intr_en, nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER } }, 
-            { NV_PMC_INTR_READ_0, { &this->pmc.intr_read, nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER } },
-            { NV_PMC_ENABLE, { &this->pmc.enable, nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER } },
+        // MMIO decode 
+        // Two-level table over NV_PMC..NV_USER_START: the top level is indexed by 4KB page, each page that has registers
+        // in it gets one slot per 32-bit register. The whole thing is generated at compile time from nv1_mappings32 (nv1_mmio.hpp)
+        #define NV1_MMIO_PAGE_SHIFT             12
+        #define NV1_MMIO_PAGE_MASK              ((1 << NV1_MMIO_PAGE_SHIFT) - 1)
+        #define NV1_MMIO_NUM_PAGES              (NV_USER_START >> NV1_MMIO_PAGE_SHIFT)
+        #define NV1_MMIO_SLOTS_PER_PAGE         ((1 << NV1_MMIO_PAGE_SHIFT) >> 2)
 
-            // PFB
-            { NV_PFB_BOOT_0, { &this->pfb.boot, nullptr, nullptr, "Framebuffer Manufacture-Time Configuration", NV1_SINGLE_REGISTER } },
-            { NV_PFB_CONFIG_0, { &this->pfb.config, nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER } }, 
-        
-            // PFIFO
-            { NV_PFIFO_INTR_0, { &this->pfifo.intr, nullptr, nullptr, "PFIFO Interrupt Status", NV1_SINGLE_REGISTER } } ,
-            { NV_PFIFO_INTR_EN_0, { &this->pfifo.intr_en, nullptr, nullptr, "PFIFO Interrupt Enable", NV1_SINGLE_REGISTER } } ,
-            { NV_PFIFO_CONFIG_0, { &this->pfifo.config, nullptr, nullptr, "PFIFO General Config", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHES, { &this->pfifo.cache_reassignment, nullptr, nullptr, "PFIFO Cache Reassignment (Context Switching) Enable", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE0_PUSH0, { &this->pfifo.cache0.cache_data.push_access_enable, nullptr, nullptr, "PFIFO CACHE0 Push0 (Push Access Enabled)", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE1_PUSH0, { &this->pfifo.cache1.cache_data.push_access_enable, nullptr, nullptr, "PFIFO CACHE1 Push0 (Push Access Enabled)", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE0_PUSH1, { &this->pfifo.cache0.cache_data.push_channel_id, nullptr, nullptr, "PFIFO CACHE0 Push1 (Channel ID)", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE1_PUSH1, { &this->pfifo.cache1.cache_data.push_channel_id, nullptr, nullptr, "PFIFO CACHE1 Push0 (Channel ID)", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE0_PULL0, { &this->pfifo.cache0.cache_data.pull0, nullptr, nullptr, "PFIFO CACHE0 Pull Settings 0 (bit8 - Hardware or Software (object?) - bit4 set if hash failed; bit 0 - access enabled)", NV1_SINGLE_REGISTER }} ,
-            { NV_PFIFO_CACHE1_PULL0, { &this->pfifo.cache1.cache_data.pull0, nullptr, nullptr, "PFIFO CACHE1 Pull Settings 0 (bit8 - Hardware or Software (method?) - bit4 set if hash failed; bit 0 - access enabled)", NV1_SINGLE_REGISTER }} ,
-            { NV_PFIFO_CACHE0_PULL1, { &this->pfifo.cache0.cache_data.pull1, nullptr, nullptr, "PFIFO CACHE0 Pull Settings 1 (bit8 - Object Changed?; bit4 - 1 if context is dirty; bits 2-0: subchannel", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE1_PULL1, { &this->pfifo.cache1.cache_data.pull1, nullptr, nullptr, "PFIFO CACHE1 Pull Settings 1 (bit8 - Object Changed?; bit4 - 1 if context is dirty; bits 2-0: subchannel", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE0_STATUS, { &this->pfifo.cache0.cache_data.status, nullptr, nullptr, "PFIFO CACHE0 Status", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE1_STATUS, { &this->pfifo.cache1.cache_data.status, nullptr, nullptr, "PFIFO CACHE1 Status", NV1_SINGLE_REGISTER } },
-            { NV_PFIFO_CACHE0_CTX(0), { &this->pfifo.cache0.cache_data.context[0], nullptr, nullptr, "PFIFO Cache0 Subchannel Context Registers", NV_PFIFO_CACHE0_CTX(NV_PFIFO_CACHE0_CTX__SIZE_1) } },
-
-            // PRAM
-            { NV_PRAM_CONFIG_0, { &this->pram.config, nullptr, &NV1::SetRAMINConfig, nullptr } }, 
-            
-            // PEXTDEV/STRAPS
-            { NV_PEXTDEV_BOOT_0, { &this->straps, nullptr, nullptr, "Straps (OEM Configuration)"}  }, 
-        }; 
+        // Find the mapping for an address, and the element of it for array registers (nv1_mmio.hpp)
+        inline const NV1Mapping* MMIOFindMapping(uint32_t addr, uint32_t& index);
 
-        void Start()
+        // Get the backing store of a mapping
+        inline uint32_t* MMIORegister(const NV1Mapping* mapping, uint32_t index)
         {
-            state.running = true;
+            return (uint32_t*)((uint8_t*)this + mapping->reg + index * mapping->reg_stride);
         }
 
-        uint32_t ReadRegister32(uint32_t addr) 
+        // Write to a decoded register (nv1_mmio.hpp)
+        inline void MMIOWrite(const NV1Mapping* mapping, uint32_t index, uint32_t value);
+
+        // USER space decode. Each channel gets 64KB, split into 8KB per subchannel
+        #define NV1_USER_CHANNEL(addr)          (((addr) >> 16) & 0x7F)
+        #define NV1_USER_SUBCHANNEL(addr)       (((addr) >> 13) & 0x07)
+        #define NV1_USER_METHOD(addr)           ((addr) & 0xFFFC)           // subchannel (15:13) and method (12:2), same layout as NV_PFIFO_CACHE1_METHOD
+        #define NV1_USER_SUBCHANNEL_MASK        0x1FFF
+
+        // RAMIN is also visible through MMIO, just below USER space
+        #define NV1_PRAMIN_START                0x00700000
+
+        void Start();
+        void Stop();
+
+        inline uint32_t ReadRegister32(uint32_t addr);
+        inline void WriteRegister32(uint32_t addr, uint32_t value);
+
+        // Write a stream of (address, value) pairs, e.g. captured driver traffic.
+        // Runs of writes that stay within one register page or one channel's subchannel are only decoded once
+        void WriteRegisters32(std::span<const std::pair<uint32_t, uint32_t>> writes);
+
+        // Interrupt status registers are brought up to date whenever they are read
+        uint32_t ReadPendingInterrupts();
+        uint32_t PGRAPHReadIntr0();
+
+        // PGRAPH might still be drawing into VRAM on the puller thread, so let it finish first
+        uint8_t ReadVRAM8(uint32_t addr) { PFIFOWaitForPuller(); return state.video_ram8[addr]; }; 
+        uint16_t ReadVRAM16(uint32_t addr) { PFIFOWaitForPuller(); return state.video_ram16[addr >> 1]; }; 
+        uint32_t ReadVRAM32(uint32_t addr) { PFIFOWaitForPuller(); return state.video_ram32[addr >> 2]; }; 
+        void WriteVRAM8(uint32_t addr, uint32_t value) { PFIFOWaitForPuller(); state.video_ram8[addr] = value; }; 
+        void WriteVRAM16(uint32_t addr, uint32_t value) { PFIFOWaitForPuller(); state.video_ram16[addr >> 1] = value; }; 
+        void WriteVRAM32(uint32_t addr, uint32_t value) { PFIFOWaitForPuller(); state.video_ram32[addr >> 2] = value; }; 
+        
+        // RAMIN
+        uint32_t ReadRAMIN32(uint32_t addr) 
         { 
-            if (addr <= NV_USER_START)
-            {
-                // check the address exists
-                // by default, operator[] creates an element, so we create every index implicitly (once)
-                // this is probably faster than a manual search
-                
-                NV1Mapping mapping = mappings32[addr];
-                bool isRedirect = (mapping.reg == nullptr);
-                uint32_t index = 0;
-
-                if (mapping.reg == nullptr
-                && isRedirect)
-                {
-                    uint32_t start_addr = addr;
-
-                    // mapping doesn't exist, find one that does
-                    while (mapping.reg == nullptr
-                    && addr >= 0)
-                    {
-                        addr -= 4;
-                        mapping = mappings32[addr];
-                    }
-
-                    // now we are pointing to a real mapping
-                    uint32_t real_ptr_new = addr;
-                    uint32_t cur_index = (start_addr - addr) >> 2;                 // index *our* addr reprensets
-
-                    for (uint32_t temp_addr = start_addr + 4; temp_addr > addr; temp_addr -= 4)
-                    {
-                        // index 0 not needed
-                        mappings32[temp_addr].real_ptr = addr; 
-                        mappings32[temp_addr].index = cur_index;
-                        cur_index--;
-                    }
-
-                    //use access function
-                }
-
-                // get the real pointer
-                if (mapping.real_ptr != 0xFFFFFFFF)
-                {
-                    //store index
-                    index = mapping.index;
-                    mapping = mappings32[mapping.real_ptr];
-                }
-
-                if (mappings32[addr].read_func)
-                    return (this->*this->mappings32[addr].read_func)();
-                else
-                    return *mappings32[addr].reg; 
-            }
-            else
-            {
-                
-                uint32_t channel_number = (addr & 0x7FFFFF);
-                uint32_t subchannel_number = (addr >> 13) % 8; // number of subchannels
-
-                // channel offset
-                switch (addr & 0x1FFC)
-                {
-                    case NV_CHANNEL_OFFSET_FREE_COUNT_START ... NV_CHANNEL_OFFSET_FREE_COUNT_END:
-                        return pfifo.cache1.GetFreeSpaces();
-                }
-            }
+            // Channel contexts are only written back to RAMFC when they're needed
+            if (addr - pram.ramfc_start < pram.ramfc_size)
+                PFIFOStoreChannelContext((addr - pram.ramfc_start) / NV1_RAMFC_ENTRY_SIZE);
+
+            return state.video_ram32[GetRAMINAddress(addr) >> 2]; 
         };
 
-        void WriteRegister32(uint32_t addr, uint32_t value)
+        void WriteRAMIN32(uint32_t addr, uint32_t value) 
         { 
-            if (addr <= NV_USER_START)
-            {
-                if (mappings32[addr].write_func)
-                    (this->*this->mappings32[addr].write_func)(value);
-                else 
-                    *mappings32[addr].reg = value; 
-            }
-            else
-            {
-                uint32_t channel_number = (addr & 0x7FFFFF);
-                uint32_t subchannel_number = (addr >> 13) % 8; // number of subchannels
-
-                // channel offset
-                switch (addr & 0x1FFC)
-                {
-                    
-                }
-            }
-        };
+            // Anything cached from RAMHT might be stale now
+            if (addr - pram.ramht_start < pram.ramht_size)
+                RAMHTInvalidate();
+            
+            // Someone is writing a channel's RAMFC entry themselves, so reload it from there next time
+            if (addr - pram.ramfc_start < pram.ramfc_size)
+                PFIFODiscardChannelContext((addr - pram.ramfc_start) / NV1_RAMFC_ENTRY_SIZE);
 
-        uint8_t ReadVRAM8(uint32_t addr) { return state.video_ram8[addr]; }; 
-        uint16_t ReadVRAM16(uint32_t addr) { return state.video_ram16[addr >> 1]; }; 
-        uint32_t ReadVRAM32(uint32_t addr) { return state.video_ram32[addr >> 2]; }; 
-        void WriteVRAM8(uint32_t addr, uint32_t value) { state.video_ram8[addr] = value; }; 
-        void WriteVRAM16(uint32_t addr, uint32_t value) { state.video_ram16[addr >> 1] = value; }; 
-        void WriteVRAM32(uint32_t addr, uint32_t value) { state.video_ram32[addr >> 2] = value; }; 
-        
-        // RAMIN
-        uint32_t ReadRAMIN32(uint32_t addr) { return state.video_ram32[GetRAMINAddress(addr) >> 2]; };
-        void WriteRAMIN32(uint32_t addr, uint32_t value) { state.video_ram32[GetRAMINAddress(addr) >> 2] = value; };
+            state.video_ram32[GetRAMINAddress(addr) >> 2] = value; 
+        };
     
         // Register stuff
         void SetRAMINConfig(uint32_t value);
 
         void PFIFOCache0Push();
         void PFIFOCache0Pull();
-        void PFIFOCache1Push();
-        void PFIFOCache1Pull();
+        void PFIFOCache1Push(uint32_t channel, uint32_t method, uint32_t param);
+        void PFIFOCache1PushRun(uint32_t channel, std::span<const std::pair<uint32_t, uint32_t>> writes);
+        bool PFIFOCache1Pull(PFIFOCacheEntry& entry);
+        void PFIFOUpdate();
+        void PFIFOPullerThread();
+        void PFIFOWakePuller();
+        void PFIFOWaitForPuller();
+        void PFIFOWaitForFree();
+        void PFIFOSetObject(uint32_t channel, uint32_t subchannel, uint32_t handle);
+        void PFIFOSwitchChannel(uint32_t channel);
+        void PFIFOLoadChannelContext(uint32_t channel);
+        void PFIFOStoreChannelContext(uint32_t channel);
+        void PFIFODiscardChannelContext(uint32_t channel);
+
+        // RAMRO
+        #define NV1_RAMRO_ENTRY_SIZE            8
+
+        // A method that couldn't be put into CACHE1, as stored in RAMRO
+        struct PFIFORunoutEntry
+        {
+            uint32_t method;                        // Subchannel and method offset
+            uint32_t channel;
+            uint32_t reason;                        // NV_RAMRO_REASON_*
+            uint32_t param;
+        };
+
+        void PFIFORunout(uint32_t channel, uint32_t method, uint32_t param, uint32_t reason);
+        uint32_t PFIFOReadRunout(std::span<PFIFORunoutEntry> entries);
+
+        // RAMHT
+        uint32_t RAMHTHash(uint32_t handle, uint32_t channel);
+        bool RAMHTLookup(uint32_t handle, uint32_t channel, uint32_t& context);
+        void RAMHTInvalidate();
+
+        uint32_t PFIFOReadCache1Status();
+        uint32_t PFIFOReadCache1Get();
+        void PFIFOWriteCache1Get(uint32_t value);
+        uint32_t PFIFOReadCache1Put();
+        void PFIFOWriteCache1Put(uint32_t value);
+        uint32_t PFIFOReadRunoutStatus();
+
+        // Where PGRAPH draws
+        struct PGRAPHSurface
+        {
+            uint32_t width;                         // In pixels
+            uint32_t height;
+            uint32_t pitch;                         // In bytes
+            uint32_t bytes_per_pixel;               // 0 if PGRAPH can't draw at this depth
+        };
+
+        // right and bottom are exclusive
+        struct PGRAPHRect
+        {
+            int32_t left;
+            int32_t top;
+            int32_t right;
+            int32_t bottom;
+        };
+
+        // GDI ROP3 codes that get special treatment
+        #define NV1_ROP_SRCCOPY                 0xCC
+        #define NV1_ROP_PATCOPY                 0xF0
+        #define NV1_ROP_DSTCOPY                 0xAA
+
+        // Fill a span of bytes with a dword that repeats from the start of VRAM
+        typedef void (*PGRAPHFillSpanFn)(uint8_t* dst, uint32_t bytes, uint32_t pattern);
+
+        // Apply a ROP3 to a span of bytes. src and pattern are the source and pattern pixels for the same span
+        typedef void (*PGRAPHRop3SpanFn)(uint8_t* dst, const uint8_t* src, const uint8_t* pattern, uint32_t bytes);
+
+        #define NV1_PGRAPH_MAX_PITCH            (1600 * 4)
+
+        // What beta blending, the chroma key and the plane mask do to writes
+        struct PGRAPHWriteMask
+        {
+            bool blend;                             // Blend what would be written with what's already there
+            uint32_t beta;                          // How much of what would be written is kept, out of 256
+            bool chroma;                            // Don't write pixels whose source matches chroma_key
+            uint32_t chroma_key;                    // In the framebuffer's format
+            uint32_t chroma_mask;                   // The colour bits of a pixel, the only ones compared with chroma_key
+            uint32_t plane_mask;                    // In the framebuffer's format. Bits that are 0 aren't written
+            bool active;                            // False if every pixel and bit gets written as it is
+        };
+
+        // Triangles are rasterised a tile at a time. Tiles don't share any pixels, so they can be done in any order, or at the same time
+        #define NV1_PGRAPH_TILE_SIZE            32
+
+        // A triangle that is ready to be rasterised. Edge functions are in half pixels, so that pixel centres are at odd coordinates
+        struct PGRAPHTriangleSetup
+        {
+            int64_t edge_a[3];                      // E = a * x + b * y + c
+            int64_t edge_b[3];
+            int64_t edge_c[3];
+            int64_t threshold[3];                   // A pixel is inside if E >= threshold for every edge. 0 for top and left edges, which own the pixels on them
+            PGRAPHRect bounds;                      // Bounding box, clipped
+            PGRAPHSurface surface;
+            PGRAPHWriteMask mask;
+            uint32_t pattern;                       // The colour, repeated across a dword
+            alignas(32) uint8_t color_row[NV1_PGRAPH_MAX_PITCH];    // The colour, as the source for the ROP
+
+            // Everything a tile needs from PGRAPH is resolved here, so tiles only ever read the setup
+            bool solid;                             // SRCCOPY with nothing masked, so every span is a plain fill
+            PGRAPHFillSpanFn fill_span;
+            PGRAPHRop3SpanFn rop_span;
+            const PGRAPHPatternCache* pattern_cache;    // nullptr if the ROP doesn't use the pattern
+        };
+
+        // A line waiting to be drawn. Lines are drawn in batches, so everything about them is set up once per batch
+        #define NV1_PGRAPH_LINE_BATCH_SIZE      64
+
+        struct PGRAPHLine
+        {
+            int32_t x0;
+            int32_t y0;
+            int32_t x1;
+            int32_t y1;
+            uint32_t color;
+        };
+
+        // Everything about drawing lines that stays the same for a whole batch, apart from the colour
+        struct PGRAPHLineState
+        {
+            NV1* gpu;
+            PGRAPHSurface surface;
+            PGRAPHRect clip;
+            PGRAPHWriteMask mask;
+            bool solid;                                 // SRCCOPY with nothing masked, so runs are plain fills
+            PGRAPHFillSpanFn fill_span;
+            PGRAPHRop3SpanFn rop_span;
+            const PGRAPHPatternCache* pattern_cache;    // nullptr if the ROP doesn't use the pattern
+            uint32_t pattern;                           // The line's colour, repeated across a dword
+            alignas(32) uint8_t color_row[NV1_PGRAPH_MAX_PITCH];    // The line's colour, as the source for the ROP
+        };
+
+        // A point waiting to be drawn. Points are batched up like lines
+        #define NV1_PGRAPH_POINT_BATCH_SIZE     256
+
+        struct PGRAPHPoint
+        {
+            int32_t x;
+            int32_t y;
+            uint32_t color;
+        };
+
+        void PGRAPHInit();
+        void PGRAPHMethod(uint32_t method, uint32_t param);
+        void PGRAPHFlush();
+        PGRAPHSurface PGRAPHGetSurface();
+        PGRAPHRect PGRAPHGetClip(const PGRAPHSurface& surface);
+        bool PGRAPHClipBounds(PGRAPHRect& bounds, const PGRAPHRect& clip);
+        static bool PGRAPHClipRect(PGRAPHRect& bounds, const PGRAPHRect& clip);
+        void PGRAPHCountClip(int32_t x, int32_t y, uint32_t width, uint32_t height);
+        static uint32_t PGRAPHConvertColor(uint32_t color, const PGRAPHSurface& surface);
+        static uint32_t PGRAPHUnconvertColor(uint32_t color, const PGRAPHSurface& surface);
+        uint32_t PGRAPHObjectColor(uint32_t color, const PGRAPHSurface& surface);
+        static uint32_t PGRAPHRepeatColor(uint32_t color, const PGRAPHSurface& surface);
+        void PGRAPHFillRect(int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t color);
+        const PGRAPHPatternCache& PGRAPHGetPattern(const PGRAPHSurface& surface);
+        const PGRAPHPatternCache* PGRAPHGetRopPattern(uint8_t rop, const PGRAPHSurface& surface);
+        void PGRAPHExpandPattern(int32_t x, int32_t y, uint32_t count, const PGRAPHSurface& surface, uint8_t* row);
+        static void PGRAPHExpandPattern(const PGRAPHPatternCache& pattern, int32_t x, int32_t y, uint32_t count, const PGRAPHSurface& surface, uint8_t* row);
+        static void PGRAPHKeepTransparent(uint8_t* dst, const uint8_t* original, const PGRAPHPatternCache& pattern, int32_t x, int32_t y, uint32_t pixels, const PGRAPHSurface& surface);
+        static PGRAPHFillSpanFn PGRAPHGetFillSpan();
+        static PGRAPHRop3SpanFn PGRAPHGetRop3Span(uint8_t rop);
+        PGRAPHWriteMask PGRAPHGetWriteMask(const PGRAPHSurface& surface);
+        static void PGRAPHBlendSpan(uint8_t* out, const uint8_t* src, const uint8_t* dst, uint32_t pixels, uint32_t beta, const PGRAPHSurface& surface);
+        static void PGRAPHMaskSpan(uint8_t* dst, const uint8_t* result, const uint8_t* src, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask);
+        uint32_t PGRAPHGetBetaFactor();
+        void PGRAPHWriteSpanMasked(uint8_t* dst, const uint8_t* result, const uint8_t* src, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask);
+        void PGRAPHBlit(int32_t src_x, int32_t src_y, int32_t dst_x, int32_t dst_y, uint32_t width, uint32_t height);
+        void PGRAPHImageLine(int32_t x, int32_t y, uint32_t width, const uint8_t* pixels);
+        void PGRAPHWriteSpan(uint8_t* dst, const uint8_t* src, int32_t x, int32_t y, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask);
+        void PGRAPHWriteSpanRop(uint8_t* dst, const uint8_t* src, int32_t x, int32_t y, uint32_t pixels, const PGRAPHSurface& surface, const PGRAPHWriteMask& mask,
+        PGRAPHRop3SpanFn rop_span, const PGRAPHPatternCache* pattern);
+        void PGRAPHMonoLine(int32_t x, int32_t y, uint32_t width, const uint8_t* bits);
+        void PGRAPHTriangle(const int32_t x[3], const int32_t y[3], uint32_t color);
+        void PGRAPHTriangleTile(const PGRAPHTriangleSetup& setup, const PGRAPHRect& tile);
+        void PGRAPHLines(std::span<const PGRAPHLine> lines, bool last_pixel);
+        void PGRAPHPoints(std::span<const PGRAPHPoint> points);
+        const PGRAPHPatchMesh& PGRAPHGetPatchMesh(uint32_t order, const int32_t control_x[NV1_PGRAPH_PATCH_MAX_POINTS], const int32_t control_y[NV1_PGRAPH_PATCH_MAX_POINTS], const int32_t* control_beta, uint32_t subdivide);
+        template <uint32_t order> void PGRAPHTessellatePatch(PGRAPHPatchMesh& mesh);
+        void PGRAPHPatchRow(const PGRAPHPatchMesh& mesh, uint32_t row, const uint32_t* texels);
+        void PGRAPHPatchRowRects(const PGRAPHPatchMesh& mesh, uint32_t row, const uint32_t* texels);
+
+        // UTOMEM readback. The host provides the buffer that images are read back into
+        void PGRAPHSetReadbackBuffer(std::span<uint8_t> buffer);
+        void PGRAPHReadback(int32_t x, int32_t y, uint32_t width, uint32_t height, uint32_t start, int32_t pitch, bool notify);
+        void PGRAPHWaitForReadback();
+        void PGRAPHReadbackThread();
+        void PGRAPHWakeReadback();
+        void PGRAPHReadbackCopy(const PGRAPHReadbackJob& job);
     }; 
-}
\ No newline at end of file
+}
+
+// The register table and decoder need a complete NV1
+#include "nv1_mmio.hpp"
\ No newline at end of file
@@ -10,33 +10,273 @@
 
 namespace NV1Sim
 {
+    // The class ID of an object is the device ID stored with it in RAMHT. It's also where the class is in the NV_U* address space
+    #define NV1_CLASS_ID(addr)              (((addr) >> 16) & 0x7F)
+
+    // Offset of a method within its class, in the same format as the method offsets that PGRAPH gets from CACHE1
+    #define NV1_CLASS_METHOD(addr)          ((addr) & 0x1FFC)
+
     class NV1UBase
     {
-    public: 
-        struct NV1MethodMapping
+    public:
+        NV1UBase(NV1* gpuref)
         {
-            // Methods are write-only
-            void (NV1UBase::*function)();
-            const char* name;
-            uint32_t start;
-            uint32_t end;
-        };
+            gpu = gpuref;
+        }
 
-        NV1UBase(NV1* gpuref)
+        virtual ~NV1UBase() = default;
+
+        // Methods are write-only. Anything a class doesn't handle itself ends up here
+        virtual void Method(uint32_t offset, uint32_t param);
+
+        // Draw anything the class has queued up. PGRAPH calls this before anything else can draw
+        virtual void Flush() { }
+
+    protected:
+        NV1* gpu;
+    };
+
+    // Sets the beta factor that the beta classes are blended with
+    class NV1UBeta : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+    };
+
+    // Sets the user clip rectangle, which nothing is drawn outside of
+    class NV1UClip : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+    };
+
+    // Sets the pattern that ROPs use
+    class NV1UPatt : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+    };
+
+    // Sets the ROP3 for everything that's drawn after it
+    class NV1URop : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+    };
+
+    // Solid rectangles
+    class NV1URect : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        uint32_t color = 0;
+        int32_t x = 0;                      // Position of the rectangle whose size is written next
+        int32_t y = 0;
+    };
+
+    // Single pixels
+    class NV1UPoint : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+        void Flush() override;
+
+    private:
+        void Point(int32_t x, int32_t y, uint32_t point_color);
+
+        uint32_t color = 0;
+        uint32_t cpoint_color = 0;          // Colour of the next CPOINT
+        int32_t point_x = 0;                // X of a 32-bit point, waiting for its Y
+        NV1::PGRAPHPoint batch[NV1_PGRAPH_POINT_BATCH_SIZE];
+        uint32_t batch_points = 0;
+    };
+
+    // Lines and polylines. NV_ULINE draws the last pixel of each line, NV_ULIN doesn't, but otherwise they are the same
+    class NV1ULine : public NV1UBase
+    {
+    public:
+        NV1ULine(NV1* gpuref, bool draw_last_pixel) : NV1UBase(gpuref)
         {
-            gpu = gpuref; 
-        }  
-    
-        virtual NV1MethodMapping GetMapping(uint32_t addr)
+            last_pixel = draw_last_pixel;
+        }
+
+        void Method(uint32_t offset, uint32_t param) override;
+        void Flush() override;
+
+    private:
+        void Line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t line_color);
+        void PolylineVertex(uint32_t index, int32_t x, int32_t y, uint32_t line_color);
+
+        bool last_pixel;
+        uint32_t color = 0;
+        uint32_t cpolyline_color = 0;       // Colour of the next CPOLYLINE vertex
+        int32_t start_x = 0;                // Start of the line whose end is written next, or the last polyline vertex
+        int32_t start_y = 0;
+        int32_t end_x = 0;                  // X of a 32-bit vertex, waiting for its Y
+        NV1::PGRAPHLine batch[NV1_PGRAPH_LINE_BATCH_SIZE];
+        uint32_t batch_lines = 0;
+    };
+
+    // Flat shaded triangles and triangle meshes
+    class NV1UTri : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        void Draw();
+        void MeshVertex(int32_t vertex_x, int32_t vertex_y);
+
+        uint32_t color = 0;
+        int32_t x[3] = { };
+        int32_t y[3] = { };
+        int32_t mesh_x = 0;                 // X of a 32-bit mesh vertex, waiting for its Y
+        uint32_t mesh_vertices = 0;         // Vertices of the current mesh so far, up to 3
+    };
+
+    // Texture patches. Quadratic patches (NV_UQTM) have 9 control points in a 3x3 grid with 0, 2, 6 and 8 at the corners,
+    // bilinear ones (NV_UBTM) just have the 4 corners. SUBDIVIDE_IN says how big the texture is, which is then sent through
+    // COLOR a texel at a time and drawn a row at a time. The beta variants (NV_UBTMB and NV_UQTMB) also have a beta for each
+    // control point, and are blended with what's already there
+    class NV1UTexture : public NV1UBase
+    {
+    public:
+        NV1UTexture(NV1* gpuref, uint32_t patch_order, bool beta) : NV1UBase(gpuref)
         {
-            return baseMappings[addr]; 
-        };
-    private: 
-    
-        NV1* gpu;
-        // Methods below 0x0100 are here
-        std::unordered_map<uint32_t, NV1MethodMapping> baseMappings;
+            order = patch_order;
+            blended = beta;
+        }
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        void Texel(uint32_t param);
+
+        uint32_t order;                     // 1 for bilinear, 2 for quadratic
+        bool blended;
+        int32_t control_x[NV1_PGRAPH_PATCH_MAX_POINTS] = { };     // 12.4
+        int32_t control_y[NV1_PGRAPH_PATCH_MAX_POINTS] = { };
+        uint32_t row = 0;                   // Row of the texture that's being received
+        uint32_t column = 0;
+        uint32_t texels[NV1_PGRAPH_PATCH_MAX_SIZE];
+    };
+
+    // Screen to screen blits
+    class NV1UBlit : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        uint32_t point_in = 0;              // 31:16 - y, 15:0 - x
+        uint32_t point_out = 0;             // 31:16 - y, 15:0 - x
+    };
+
+    // Images that the CPU sends through the COLOR methods. These are put together a scanline at a time in the framebuffer's
+    // format and drawn a whole scanline at once
+    class NV1UImage : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        void Color(uint32_t param);
+        void CommitStaging();
+
+        int32_t x = 0;
+        int32_t y = 0;
+        uint32_t width = 0;                 // How much of the image gets drawn
+        uint32_t height = 0;
+        uint32_t width_in = 0;              // How big the image that's being sent is
+        uint32_t height_in = 0;
+
+        uint32_t bytes_per_pixel = 0;
+        uint32_t line = 0;                  // Line of the image that's being received
+        uint32_t line_bytes = 0;            // Each line starts on a new COLOR word
+        uint32_t line_offset = 0;           // Bytes of this line received so far
+        uint32_t staging_pixel = 0;         // Pixel of the line at the start of staging
+        uint32_t staging_bytes = 0;
+        alignas(32) uint8_t staging[NV1_PGRAPH_MAX_PITCH];
+    };
+
+    // Images that are already in memory
+    class NV1UFromem : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        void Transfer(uint32_t start);
+
+        uint32_t point = 0;                 // 31:16 - y, 15:0 - x
+        uint32_t size = 0;                  // 31:16 - height, 15:0 - width
+        int32_t pitch = 0;                  // Bytes between lines of the image in memory
+        alignas(32) uint8_t staging[NV1_PGRAPH_MAX_PITCH];
+    };
+
+    // Copies a rectangle of the framebuffer out to the host's readback buffer, in the background
+    class NV1UToMem : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        uint32_t point = 0;                 // 31:16 - y, 15:0 - x
+        uint32_t size = 0;                  // 31:16 - height, 15:0 - width
+        int32_t pitch = 0;
+        bool notify = false;                // Notify when the next readback is done
+    };
+
+    // Monochrome bitmaps (mostly text), drawn in mono_color0 and mono_color1. Each line of the bitmap is put together in
+    // staging and expanded a whole line at a time
+    #define NV1_UBITMAP_STAGING_SIZE        512
+
+    class NV1UBitmap : public NV1UBase
+    {
+    public:
+        using NV1UBase::NV1UBase;
+
+        void Method(uint32_t offset, uint32_t param) override;
+
+    private:
+        void Monochrome(uint32_t param);
+        void CommitStaging();
 
+        int32_t x = 0;
+        int32_t y = 0;
+        uint32_t width = 0;                 // How much of the bitmap gets drawn
+        uint32_t height = 0;
+        uint32_t width_in = 0;              // How big the bitmap that's being sent is
+        uint32_t height_in = 0;
 
+        uint32_t line = 0;                  // Line of the bitmap that's being received. Each line starts on a new MONOCHROME word
+        uint32_t line_pixels = 0;           // Pixels of this line received so far
+        uint32_t staging_pixel = 0;         // Pixel of the line at the start of staging
+        uint32_t staging_pixels = 0;
+        alignas(8) uint8_t staging[NV1_UBITMAP_STAGING_SIZE + 8];  // PGRAPHMonoLine reads past the end
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,423 @@
+//
+// NV1Sim - The Nvidia NV1 Multimedia Accelerator Simulator
+// Copyright © 2025 starfrost
+//
+// nv1_mmio.hpp: MMIO register table and the decoder generated from it at compile time
+// Included at the bottom of nv1.hpp, because everything here needs a complete NV1.
+//
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+namespace NV1Sim
+{
+    // Offset of a register's backing store within the NV1. Needs NV1 to be standard layout
+    #define NV1_REG(member)                 offsetof(NV1, member)
+
+    static_assert(std::is_standard_layout_v<NV1>, "NV1 must be standard layout for NV1_REG to work");
+
+    // end, stride and reg_stride of an array register backed by a plain uint32_t array
+    #define NV1_REGISTER_ARRAY(reg, size)   reg(size), (reg(1) - reg(0)), sizeof(uint32_t)
+
+    // nearly every register is 32bit so we can get away with this
+    // we don't bother emulating the DAC, because the "DAC" is basically SDL
+    // Array registers have their base address here, "end" is one past the last element
+    inline constexpr NV1::NV1Mapping nv1_mappings32[] =
+    {
+        // PMC
+        { NV_PMC_BOOT_0, NV1_REG(pmc.boot), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PMC_DEBUG_0, NV1_REG(pmc.debug_0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PMC_INTR_0, NV1_REG(pmc.intr), &NV1::ReadPendingInterrupts, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PMC_INTR_EN_0, NV1_REG(pmc.intr_en), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PMC_INTR_READ_0, NV1_REG(pmc.intr_read), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PMC_ENABLE, NV1_REG(pmc.enable), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PMC_WATCHDOG, NV1_REG(pmc.watchdog), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+
+        // PFIFO
+        { NV_PFIFO_DELAY_0, NV1_REG(pfifo.delay_0), nullptr, nullptr, "PFIFO Delay", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_DEBUG_0, NV1_REG(pfifo.debug_0), nullptr, nullptr, "PFIFO Debug", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_INTR_0, NV1_REG(pfifo.intr), nullptr, nullptr, "PFIFO Interrupt Status", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_INTR_EN_0, NV1_REG(pfifo.intr_en), nullptr, nullptr, "PFIFO Interrupt Enable", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CONFIG_0, NV1_REG(pfifo.config), nullptr, nullptr, "PFIFO General Config", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_RUNOUT_STATUS, NV1_REG(pfifo.runout_status), &NV1::PFIFOReadRunoutStatus, nullptr, "PFIFO Runout Status", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_RUNOUT_PUT, NV1_REG(pfifo.runout_put_address), nullptr, nullptr, "PFIFO Runout Put Address", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_RUNOUT_GET, NV1_REG(pfifo.runout_get_address), nullptr, nullptr, "PFIFO Runout Get Address", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHES, NV1_REG(pfifo.cache_reassignment), nullptr, nullptr, "PFIFO Cache Reassignment (Context Switching) Enable", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_DEVICE(0), NV1_REG(pfifo.device[0]), nullptr, nullptr, "PFIFO Device Channel Assignments", NV1_REGISTER_ARRAY(NV_PFIFO_DEVICE, NV_PFIFO_DEVICE__SIZE_1) },
+        { NV_PFIFO_CACHE0_PUSH0, NV1_REG(pfifo.cache0.cache_data.push_access_enable), nullptr, nullptr, "PFIFO CACHE0 Push0 (Push Access Enabled)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE1_PUSH0, NV1_REG(pfifo.cache1.cache_data.push_access_enable), nullptr, nullptr, "PFIFO CACHE1 Push0 (Push Access Enabled)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE0_PUSH1, NV1_REG(pfifo.cache0.cache_data.push_channel_id), nullptr, nullptr, "PFIFO CACHE0 Push1 (Channel ID)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE1_PUSH1, NV1_REG(pfifo.cache1.cache_data.push_channel_id), nullptr, nullptr, "PFIFO CACHE1 Push0 (Channel ID)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE0_PULL0, NV1_REG(pfifo.cache0.cache_data.pull0), nullptr, nullptr, "PFIFO CACHE0 Pull Settings 0 (bit8 - Hardware or Software (object?) - bit4 set if hash failed; bit 0 - access enabled)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE1_PULL0, NV1_REG(pfifo.cache1.cache_data.pull0), nullptr, nullptr, "PFIFO CACHE1 Pull Settings 0 (bit8 - Hardware or Software (method?) - bit4 set if hash failed; bit 0 - access enabled)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE0_PULL1, NV1_REG(pfifo.cache0.cache_data.pull1), nullptr, nullptr, "PFIFO CACHE0 Pull Settings 1 (bit8 - Object Changed?; bit4 - 1 if context is dirty; bits 2-0: subchannel", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE1_PULL1, NV1_REG(pfifo.cache1.cache_data.pull1), nullptr, nullptr, "PFIFO CACHE1 Pull Settings 1 (bit8 - Object Changed?; bit4 - 1 if context is dirty; bits 2-0: subchannel", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE0_STATUS, NV1_REG(pfifo.cache0.cache_data.status), nullptr, nullptr, "PFIFO CACHE0 Status", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE1_STATUS, NV1_REG(pfifo.cache1.cache_data.status), &NV1::PFIFOReadCache1Status, nullptr, "PFIFO CACHE1 Status", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE0_PUT, NV1_REG(pfifo.cache0.put_address), nullptr, nullptr, "PFIFO CACHE0 Put Address", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE1_PUT, NV1_REG(pfifo.cache1.put_address), &NV1::PFIFOReadCache1Put, &NV1::PFIFOWriteCache1Put, "PFIFO CACHE1 Put Address (Gray code)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE0_GET, NV1_REG(pfifo.cache0.get_address), nullptr, nullptr, "PFIFO CACHE0 Get Address", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE1_GET, NV1_REG(pfifo.cache1.get_address), &NV1::PFIFOReadCache1Get, &NV1::PFIFOWriteCache1Get, "PFIFO CACHE1 Get Address (Gray code)", NV1_SINGLE_REGISTER },
+        { NV_PFIFO_CACHE0_CTX(0), NV1_REG(pfifo.cache0.cache_data.context[0]), nullptr, nullptr, "PFIFO Cache0 Subchannel Context Registers", NV1_REGISTER_ARRAY(NV_PFIFO_CACHE0_CTX, NV_PFIFO_CACHE0_CTX__SIZE_1) },
+        { NV_PFIFO_CACHE1_CTX(0), NV1_REG(pfifo.cache1.cache_data.context[0]), nullptr, nullptr, "PFIFO Cache1 Subchannel Context Registers", NV1_REGISTER_ARRAY(NV_PFIFO_CACHE1_CTX, NV_PFIFO_CACHE1_CTX__SIZE_1) },
+        { NV_PFIFO_CACHE0_METHOD(0), NV1_REG(pfifo.cache0_data.method), nullptr, nullptr, "PFIFO Cache0 Method", NV_PFIFO_CACHE0_METHOD(NV_PFIFO_CACHE0_METHOD__SIZE_1), (NV_PFIFO_CACHE0_METHOD(1) - NV_PFIFO_CACHE0_METHOD(0)), sizeof(uint32_t) * 2 },
+        { NV_PFIFO_CACHE0_DATA(0), NV1_REG(pfifo.cache0_data.param), nullptr, nullptr, "PFIFO Cache0 Data", NV_PFIFO_CACHE0_DATA(NV_PFIFO_CACHE0_DATA__SIZE_1), (NV_PFIFO_CACHE0_DATA(1) - NV_PFIFO_CACHE0_DATA(0)), sizeof(uint32_t) * 2 },
+        { NV_PFIFO_CACHE1_METHOD(0), NV1_REG(pfifo.cache1_data[0].method), nullptr, nullptr, "PFIFO Cache1 Methods", NV_PFIFO_CACHE1_METHOD(NV_PFIFO_CACHE1_METHOD__SIZE_1), (NV_PFIFO_CACHE1_METHOD(1) - NV_PFIFO_CACHE1_METHOD(0)), sizeof(uint32_t) * 2 },
+        { NV_PFIFO_CACHE1_DATA(0), NV1_REG(pfifo.cache1_data[0].param), nullptr, nullptr, "PFIFO Cache1 Data", NV_PFIFO_CACHE1_DATA(NV_PFIFO_CACHE1_DATA__SIZE_1), (NV_PFIFO_CACHE1_DATA(1) - NV_PFIFO_CACHE1_DATA(0)), sizeof(uint32_t) * 2 },
+
+        // PDMA
+        { NV_PDMA_RM_INTR_0, NV1_REG(pdma.rm_intr), nullptr, nullptr, "PDMA RM Interrupt Status", NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_INTR_0, NV1_REG(pdma.au_intr), nullptr, nullptr, "PDMA Audio Interrupt Status", NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_INTR_0, NV1_REG(pdma.gr_intr), nullptr, nullptr, "PDMA Graphics Interrupt Status", NV1_SINGLE_REGISTER },
+        { NV_PDMA_RM_INTR_EN_0, NV1_REG(pdma.rm_intr_en), nullptr, nullptr, "PDMA RM Interrupt Enable", NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_INTR_EN_0, NV1_REG(pdma.au_intr_en), nullptr, nullptr, "PDMA Audio Interrupt Enable", NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_INTR_EN_0, NV1_REG(pdma.gr_intr_en), nullptr, nullptr, "PDMA Graphics Interrupt Enable", NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_CONTROL, NV1_REG(pdma.au_control), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_CONTROL, NV1_REG(pdma.gr_control), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_LIMIT, NV1_REG(pdma.au_limit), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_LIMIT, NV1_REG(pdma.gr_limit), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_TLB_PTE, NV1_REG(pdma.au_tlb_pte), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_TLB_PTE, NV1_REG(pdma.gr_tlb_pte), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_CHANNEL, NV1_REG(pdma.au_channel), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_CHANNEL, NV1_REG(pdma.gr_channel), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_RM_STATUS_0, NV1_REG(pdma.rm_status_0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_STATUS_0, NV1_REG(pdma.au_status_0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_STATUS_0, NV1_REG(pdma.gr_status_0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_STATUS_1, NV1_REG(pdma.au_status_1), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_STATUS_1, NV1_REG(pdma.gr_status_1), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_TLB_TAG, NV1_REG(pdma.au_tlb_tag), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_TLB_TAG, NV1_REG(pdma.gr_tlb_tag), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_ADJ_OFFSET, NV1_REG(pdma.au_adj_offset), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_ADJ_OFFSET, NV1_REG(pdma.gr_adj_offset), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_RM_PHY_START, NV1_REG(pdma.rm_phy_start), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_PHY_START, NV1_REG(pdma.au_phy_start), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_PHY_START, NV1_REG(pdma.gr_phy_start), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_RM_BUFF_OUT(0), NV1_REG(pdma.rm_buff_out[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PDMA_RM_BUFF_OUT, NV_PDMA_RM_BUFF_OUT__SIZE_1) },
+        { NV_PDMA_AU_BUFF_OUT(0), NV1_REG(pdma.au_buff_out[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PDMA_AU_BUFF_OUT, NV_PDMA_AU_BUFF_OUT__SIZE_1) },
+        { NV_PDMA_GR_BUFF_OUT(0), NV1_REG(pdma.gr_buff_out[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PDMA_GR_BUFF_OUT, NV_PDMA_GR_BUFF_OUT__SIZE_1) },
+        { NV_PDMA_BUFF_IN(0), NV1_REG(pdma.buff_in[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PDMA_BUFF_IN, NV_PDMA_BUFF_IN__SIZE_1) },
+        { NV_PDMA_AU_INSTANCE, NV1_REG(pdma.au_instance), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_INSTANCE, NV1_REG(pdma.gr_instance), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_OFFSET, NV1_REG(pdma.au_offset), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_OFFSET, NV1_REG(pdma.gr_offset), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_OUT32, NV1_REG(pdma.au_out32), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_OUT32, NV1_REG(pdma.gr_out32), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_RM_FLUSH32, NV1_REG(pdma.rm_flush32), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_FLUSH32, NV1_REG(pdma.au_flush32), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_FLUSH32, NV1_REG(pdma.gr_flush32), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_FLUSH_BUFF, NV1_REG(pdma.au_flush_buff), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_FLUSH_BUFF, NV1_REG(pdma.gr_flush_buff), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_RM_IN, NV1_REG(pdma.rm_in), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_IN, NV1_REG(pdma.au_in), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_IN, NV1_REG(pdma.gr_in), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_AU_NOTIFY, NV1_REG(pdma.au_notify), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PDMA_GR_NOTIFY, NV1_REG(pdma.gr_notify), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+
+        // PTIMER
+        { NV_PTIMER_INTR_0, NV1_REG(ptimer.intr), nullptr, nullptr, "PTIMER Interrupt Status", NV1_SINGLE_REGISTER },
+        { NV_PTIMER_INTR_EN_0, NV1_REG(ptimer.intr_en), nullptr, nullptr, "PTIMER Interrupt Enable", NV1_SINGLE_REGISTER },
+        { NV_PTIMER_NUMERATOR, NV1_REG(ptimer.numerator), nullptr, nullptr, "PTIMER Clock Numerator", NV1_SINGLE_REGISTER },
+        { NV_PTIMER_DENOMINATOR, NV1_REG(ptimer.denominator), nullptr, nullptr, "PTIMER Clock Denominator", NV1_SINGLE_REGISTER },
+        { NV_PTIMER_TIME_0, NV1_REG(ptimer.time_0), nullptr, nullptr, "PTIMER Time (Low)", NV1_SINGLE_REGISTER },
+        { NV_PTIMER_TIME_1, NV1_REG(ptimer.time_1), nullptr, nullptr, "PTIMER Time (High)", NV1_SINGLE_REGISTER },
+        { NV_PTIMER_ALARM_0, NV1_REG(ptimer.alarm), nullptr, nullptr, "PTIMER Alarm", NV1_SINGLE_REGISTER },
+
+        // PAUDIO
+        // NV_PAUDIO_DIAG is a diagnostic window over the rest of the engine (it overlaps USAGE, TERMINATION and CONTEXT) so it is not mapped
+        { NV_PAUDIO_GREEN_0, NV1_REG(paudio.green), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_INTR_0, NV1_REG(paudio.intr), nullptr, nullptr, "PAUDIO Interrupt Status 0", NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_INTR_1, NV1_REG(paudio.intr_1), nullptr, nullptr, "PAUDIO Interrupt Status 1", NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_INTR_EN_0, NV1_REG(paudio.intr_en), nullptr, nullptr, "PAUDIO Interrupt Enable 0", NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_INTR_EN_1, NV1_REG(paudio.intr_en_1), nullptr, nullptr, "PAUDIO Interrupt Enable 1", NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_CONTEXT, NV1_REG(paudio.context), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_BLOCK_NEW, NV1_REG(paudio.block_new), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_BLOCK_ENGINE, NV1_REG(paudio.block_engine), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_BLOCK_PUMP, NV1_REG(paudio.block_pump), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_NEAR_MARK, NV1_REG(paudio.near_mark), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_SAMPLE_COUNT, NV1_REG(paudio.sample_count), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_TERMINATION, NV1_REG(paudio.termination), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_USAGE, NV1_REG(paudio.usage), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_CODEC(0), NV1_REG(paudio.codec[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PAUDIO_CODEC, NV_PAUDIO_CODEC__SIZE_1) },
+        { NV_PAUDIO_CACHE_ANALOG, NV1_REG(paudio.cache_analog), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_CACHE_INPUT, NV1_REG(paudio.cache_input), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_CACHE_OUTPUT, NV1_REG(paudio.cache_output), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_FETCH(0), NV1_REG(paudio.fetch[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PAUDIO_FETCH, NV_PAUDIO_FETCH__SIZE_1) },
+        { NV_PAUDIO_TIME_RETURN(0), NV1_REG(paudio.time_return[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PAUDIO_TIME_RETURN, NV_PAUDIO_TIME_RETURN__SIZE_1) },
+        { NV_PAUDIO_HEADER(0), NV1_REG(paudio.header[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PAUDIO_HEADER, NV_PAUDIO_HEADER__SIZE_1) },
+        { NV_PAUDIO_ROOT_INPUT, NV1_REG(paudio.root_input), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_ROOT_OUTPUT, NV1_REG(paudio.root_output), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PAUDIO_ROOT_NOTE, NV1_REG(paudio.root_note), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+
+        // PGRAPH
+        { NV_PGRAPH_DEBUG_0, NV1_REG(pgraph.debug_0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_DEBUG_1, NV1_REG(pgraph.debug_1), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_DEBUG_2, NV1_REG(pgraph.debug_2), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_DEBUG_3, NV1_REG(pgraph.debug_3), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_INTR_0, NV1_REG(pgraph.intr_0), &NV1::PGRAPHReadIntr0, nullptr, "PGRAPH Interrupt Status 0", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_INTR_1, NV1_REG(pgraph.intr_1), nullptr, nullptr, "PGRAPH Interrupt Status 1", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_INTR_EN_0, NV1_REG(pgraph.intr_en_0), nullptr, nullptr, "PGRAPH Interrupt Enable 0", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_INTR_EN_1, NV1_REG(pgraph.intr_en_1), nullptr, nullptr, "PGRAPH Interrupt Enable 1", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CTX_SWITCH, NV1_REG(pgraph.ctx_switch), nullptr, nullptr, "PGRAPH Context Switch (Current Object)", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CTX_CONTROL, NV1_REG(pgraph.ctx_control), nullptr, nullptr, "PGRAPH Context Control", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_MISC, NV1_REG(pgraph.misc), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_STATUS, NV1_REG(pgraph.status), nullptr, nullptr, "PGRAPH Status", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_TRAPPED_ADDR, NV1_REG(pgraph.trapped_addr), nullptr, nullptr, "PGRAPH Trapped Address", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_TRAPPED_DATA, NV1_REG(pgraph.trapped_data), nullptr, nullptr, "PGRAPH Trapped Data", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CANVAS_MISC, NV1_REG(pgraph.canvas_misc), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CANVAS_MIN, NV1_REG(pgraph.canvas_min), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CANVAS_MAX, NV1_REG(pgraph.canvas_max), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CLIP_MISC, NV1_REG(pgraph.clip_misc), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CLIP0_MIN, NV1_REG(pgraph.clip0_min), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CLIP0_MAX, NV1_REG(pgraph.clip0_max), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CLIP1_MIN, NV1_REG(pgraph.clip1_min), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CLIP1_MAX, NV1_REG(pgraph.clip1_max), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_DMA, NV1_REG(pgraph.dma), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_NOTIFY, NV1_REG(pgraph.notify), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_PATT_COLOR0_0, NV1_REG(pgraph.patt_0_rgb), nullptr, nullptr, "PGRAPH Pattern Colour 0 (RGB)", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_PATT_COLOR0_1, NV1_REG(pgraph.patt_0_a), nullptr, nullptr, "PGRAPH Pattern Colour 0 (Alpha)", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_PATT_COLOR1_0, NV1_REG(pgraph.patt_1_rgb), nullptr, nullptr, "PGRAPH Pattern Colour 1 (RGB)", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_PATT_COLOR1_1, NV1_REG(pgraph.patt_1_a), nullptr, nullptr, "PGRAPH Pattern Colour 1 (Alpha)", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_PATTERN(0), NV1_REG(pgraph.pattern_bitmap[0]), nullptr, nullptr, "PGRAPH Pattern Bitmap", NV1_REGISTER_ARRAY(NV_PGRAPH_PATTERN, NV_PGRAPH_PATTERN__SIZE_1) },
+        { NV_PGRAPH_PATTERN_SHAPE, NV1_REG(pgraph.pattern_shape), nullptr, nullptr, "PGRAPH Pattern Shape (0 - 8x8; 1 - 64x1; 2 - 1x64)", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_MONO_COLOR0, NV1_REG(pgraph.mono_color0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_MONO_COLOR1, NV1_REG(pgraph.mono_color1), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ROP3, NV1_REG(pgraph.rop3), nullptr, nullptr, "PGRAPH GDI ROP3", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_PLANE_MASK, NV1_REG(pgraph.plane_mask), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_CHROMA, NV1_REG(pgraph.chroma_key), nullptr, nullptr, "PGRAPH Chroma Key", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_BETA, NV1_REG(pgraph.beta), nullptr, nullptr, "PGRAPH Beta Factor", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ABS_X_RAM(0), NV1_REG(pgraph.abs_x_ram[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PGRAPH_ABS_X_RAM, NV_PGRAPH_ABS_X_RAM__SIZE_1) },
+        { NV_PGRAPH_REL_X_RAM(0), NV1_REG(pgraph.rel_x_ram[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PGRAPH_REL_X_RAM, NV_PGRAPH_REL_X_RAM__SIZE_1) },
+        { NV_PGRAPH_X_RAM_BPORT(0), NV1_REG(pgraph.x_ram[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PGRAPH_X_RAM_BPORT, NV_PGRAPH_X_RAM_BPORT__SIZE_1) },
+        { NV_PGRAPH_ABS_Y_RAM(0), NV1_REG(pgraph.abs_y_ram[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PGRAPH_ABS_Y_RAM, NV_PGRAPH_ABS_Y_RAM__SIZE_1) },
+        { NV_PGRAPH_REL_Y_RAM(0), NV1_REG(pgraph.rel_y_ram[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PGRAPH_REL_Y_RAM, NV_PGRAPH_REL_Y_RAM__SIZE_1) },
+        { NV_PGRAPH_Y_RAM_BPORT(0), NV1_REG(pgraph.y_ram[0]), nullptr, nullptr, nullptr, NV1_REGISTER_ARRAY(NV_PGRAPH_Y_RAM_BPORT, NV_PGRAPH_Y_RAM_BPORT__SIZE_1) },
+        { NV_PGRAPH_XY_LOGIC_MISC0, NV1_REG(pgraph.xy_logic_misc0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_XY_LOGIC_MISC1, NV1_REG(pgraph.xy_logic_misc1), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_X_MISC, NV1_REG(pgraph.x_misc), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_Y_MISC, NV1_REG(pgraph.y_misc), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ABS_UCLIP_XMIN, NV1_REG(pgraph.abs_uclip_xmin), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ABS_UCLIP_XMAX, NV1_REG(pgraph.abs_uclip_xmax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ABS_UCLIP_YMIN, NV1_REG(pgraph.abs_uclip_ymin), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ABS_UCLIP_YMAX, NV1_REG(pgraph.abs_uclip_ymax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_REL_UCLIP_XMIN, NV1_REG(pgraph.rel_uclip_xmin), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_REL_UCLIP_XMAX, NV1_REG(pgraph.rel_uclip_xmax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_REL_UCLIP_YMIN, NV1_REG(pgraph.rel_uclip_ymin), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_REL_UCLIP_YMAX, NV1_REG(pgraph.rel_uclip_ymax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ABS_ICLIP_XMAX, NV1_REG(pgraph.abs_iclip_xmax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_ABS_ICLIP_YMAX, NV1_REG(pgraph.abs_iclip_ymax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_REL_ICLIP_XMAX, NV1_REG(pgraph.rel_iclip_xmax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_REL_ICLIP_YMAX, NV1_REG(pgraph.rel_iclip_ymax), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_SOURCE_COLOR, NV1_REG(pgraph.source_color), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_SUBDIVIDE, NV1_REG(pgraph.subdivide), nullptr, nullptr, "PGRAPH Quadratic Patch Subdivision", NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_EXCEPTIONS, NV1_REG(pgraph.exceptions), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_EDGEFILL, NV1_REG(pgraph.edgefill), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PGRAPH_BETA_RAM(0), NV1_REG(pgraph.beta_factor_ram[0]), nullptr, nullptr, "PGRAPH Beta Factor RAM", NV1_REGISTER_ARRAY(NV_PGRAPH_BETA_RAM, NV_PGRAPH_BETA_RAM__SIZE_1) },
+        { NV_PGRAPH_BETA_RAM_BPORT(0), NV1_REG(pgraph.beta_factor_ram[0]), nullptr, nullptr, "PGRAPH Beta Factor RAM (BPORT)", NV1_REGISTER_ARRAY(NV_PGRAPH_BETA_RAM_BPORT, NV_PGRAPH_BETA_RAM_BPORT__SIZE_1) },
+        { NV_PGRAPH_BIT33, NV1_REG(pgraph.bit33), nullptr, nullptr, "PGRAPH Bit 33 (Overflow)", NV1_SINGLE_REGISTER },
+
+        // PFB
+        { NV_PFB_BOOT_0, NV1_REG(pfb.boot), nullptr, nullptr, "Framebuffer Manufacture-Time Configuration", NV1_SINGLE_REGISTER },
+        { NV_PFB_DELAY_0, NV1_REG(pfb.delay_0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_DELAY_1, NV1_REG(pfb.delay_1), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_DEBUG_0, NV1_REG(pfb.debug_0), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_GREEN_0, NV1_REG(pfb.green), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_CONFIG_0, NV1_REG(pfb.config), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_CONFIG_1, NV1_REG(pfb.config_1), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_START, NV1_REG(pfb.start), nullptr, nullptr, "Framebuffer Scanout Start", NV1_SINGLE_REGISTER },
+        { NV_PFB_HOR_FRNT_PORCH, NV1_REG(pfb.hor_frnt_porch), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_HOR_SYNC_WIDTH, NV1_REG(pfb.hor_sync_width), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_HOR_BACK_PORCH, NV1_REG(pfb.hor_back_porch), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_HOR_DISP_WIDTH, NV1_REG(pfb.hor_disp_width), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_VER_FRNT_PORCH, NV1_REG(pfb.ver_frnt_porch), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_VER_SYNC_WIDTH, NV1_REG(pfb.ver_sync_width), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_VER_BACK_PORCH, NV1_REG(pfb.ver_back_porch), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PFB_VER_DISP_WIDTH, NV1_REG(pfb.ver_disp_width), nullptr, nullptr, nullptr, NV1_SINGLE_REGISTER },
+
+        // PRAM
+        { NV_PRAM_CONFIG_0, NV1_REG(pram.config), nullptr, &NV1::SetRAMINConfig, nullptr, NV1_SINGLE_REGISTER },
+        { NV_PRAM_HASH_VIRTUAL(0), NV1_REG(pram.hash_virtual[0]), nullptr, nullptr, "RAMHT Hash Input (Handle)", NV1_REGISTER_ARRAY(NV_PRAM_HASH_VIRTUAL, NV_PRAM_HASH_VIRTUAL__SIZE_1) },
+        { NV_PRAM_HASH_PHYSICAL, NV1_REG(pram.hash_physical), nullptr, nullptr, "RAMHT Hash Output (Instance)", NV1_SINGLE_REGISTER },
+
+        // PEXTDEV/STRAPS
+        { NV_PEXTDEV_BOOT_0, NV1_REG(straps), nullptr, nullptr, "Straps (OEM Configuration)", NV1_SINGLE_REGISTER },
+    };
+
+    #define NV1_NUM_MAPPINGS32              (sizeof(nv1_mappings32) / sizeof(nv1_mappings32[0]))
+
+    // Number of addresses a mapping decodes
+    consteval uint32_t MMIONumElements(const NV1::NV1Mapping& mapping)
+    {
+        if (mapping.end == NV1_SINGLE_REGISTER)
+            return 1;
+
+        return (mapping.end - mapping.addr) / mapping.stride;
+    }
+
+    // Count the MMIO pages that have at least one register in them
+    consteval uint32_t MMIOCountPages()
+    {
+        bool populated[NV1_MMIO_NUM_PAGES] = { false };
+        uint32_t num_pages = 0;
+
+        for (const NV1::NV1Mapping& mapping : nv1_mappings32)
+        {
+            for (uint32_t index = 0; index < MMIONumElements(mapping); index++)
+            {
+                uint32_t page_number = (mapping.addr + index * mapping.stride) >> NV1_MMIO_PAGE_SHIFT;
+
+                if (!populated[page_number])
+                {
+                    populated[page_number] = true;
+                    num_pages++;
+                }
+            }
+        }
+
+        return num_pages;
+    }
+
+    #define NV1_MMIO_NUM_POPULATED_PAGES    (MMIOCountPages())
+
+    // One decoded 32-bit address
+    struct NV1MMIOSlot
+    {
+        uint16_t mapping;               // index into nv1_mappings32, +1 so that 0 means unmapped
+        uint16_t index;                 // element of an array register
+    };
+
+    // The decoder. Every element of an array register gets its own slot, so decoding never has to search
+    struct NV1MMIODecoder
+    {
+        uint16_t pages[NV1_MMIO_NUM_PAGES];                                         // index into slots, +1 so that 0 means no registers
+        NV1MMIOSlot slots[NV1_MMIO_NUM_POPULATED_PAGES][NV1_MMIO_SLOTS_PER_PAGE];
+    };
+
+    // Build the decoder. Any mistake in the table above (two registers at one address, registers over PRAMIN or USER space) fails the build
+    consteval NV1MMIODecoder MMIOBuildDecoder()
+    {
+        NV1MMIODecoder decoder = { };
+        uint16_t num_pages = 0;
+
+        for (uint32_t mapping_number = 0; mapping_number < NV1_NUM_MAPPINGS32; mapping_number++)
+        {
+            const NV1::NV1Mapping& mapping = nv1_mappings32[mapping_number];
+
+            if (mapping.end != NV1_SINGLE_REGISTER
+            && (!mapping.stride || (mapping.stride & 3) || !mapping.reg_stride))
+                throw "Array MMIO register without a valid stride";
+
+            for (uint32_t index = 0; index < MMIONumElements(mapping); index++)
+            {
+                uint32_t addr = mapping.addr + index * mapping.stride;
+
+                if (addr >= NV1_PRAMIN_START)
+                    throw "MMIO register mapped over PRAMIN or USER space";
+
+                uint32_t page_number = addr >> NV1_MMIO_PAGE_SHIFT;
+
+                if (!decoder.pages[page_number])
+                    decoder.pages[page_number] = ++num_pages;
+
+                NV1MMIOSlot& slot = decoder.slots[decoder.pages[page_number] - 1][(addr & NV1_MMIO_PAGE_MASK) >> 2];
+
+                if (slot.mapping)
+                    throw "Two MMIO registers mapped to the same address";
+
+                slot.mapping = mapping_number + 1;
+                slot.index = index;
+            }
+        }
+
+        return decoder;
+    }
+
+    inline constexpr NV1MMIODecoder nv1_mmio_decoder = MMIOBuildDecoder();
+
+    // Find the mapping for an address, and the element of it for array registers. O(1), never modifies anything
+    inline const NV1::NV1Mapping* NV1::MMIOFindMapping(uint32_t addr, uint32_t& index)
+    {
+        uint16_t page = nv1_mmio_decoder.pages[addr >> NV1_MMIO_PAGE_SHIFT];
+
+        if (!page)
+            return nullptr;
+
+        const NV1MMIOSlot& slot = nv1_mmio_decoder.slots[page - 1][(addr & NV1_MMIO_PAGE_MASK) >> 2];
+
+        if (!slot.mapping)
+            return nullptr;
+
+        index = slot.index;
+        return &nv1_mappings32[slot.mapping - 1];
+    }
+
+    inline void NV1::MMIOWrite(const NV1Mapping* mapping, uint32_t index, uint32_t value)
+    {
+        if (mapping->write_func)
+            (this->*mapping->write_func)(value);
+        else
+            *MMIORegister(mapping, index) = value;
+    }
+
+    // The puller thread uses registers all over the GPU (PFIFO, PFB, PRAM, PGRAPH) and RAMIN, so everything but USER space waits
+    // for it to finish first
+    inline uint32_t NV1::ReadRegister32(uint32_t addr)
+    {
+        if (addr < NV_USER_START)
+            PFIFOWaitForPuller();
+
+        if (addr < NV1_PRAMIN_START)
+        {
+            uint32_t index = 0;
+            const NV1Mapping* mapping = MMIOFindMapping(addr, index);
+
+            if (!mapping)
+            {
+                Logging_LogChannel("Read from unmapped MMIO address 0x%08x", LogChannel::Debug, addr);
+                return 0;
+            }
+
+            if (mapping->read_func)
+                return (this->*mapping->read_func)();
+            else
+                return *MMIORegister(mapping, index);
+        }
+        else if (addr < NV_USER_START)
+            return ReadRAMIN32(addr - NV1_PRAMIN_START);
+        else
+        {
+            // channel offset
+            switch (addr & 0x1FFC)
+            {
+                case NV_CHANNEL_OFFSET_FREE_COUNT_START ... NV_CHANNEL_OFFSET_FREE_COUNT_END:
+                    return pfifo.cache1.GetFreeSpaces();
+            }
+
+            return 0;
+        }
+    };
+
+    inline void NV1::WriteRegister32(uint32_t addr, uint32_t value)
+    {
+        if (addr < NV_USER_START)
+            PFIFOWaitForPuller();
+
+        if (addr < NV1_PRAMIN_START)
+        {
+            uint32_t index = 0;
+            const NV1Mapping* mapping = MMIOFindMapping(addr, index);
+
+            if (!mapping)
+            {
+                Logging_LogChannel("Write of 0x%08x to unmapped MMIO address 0x%08x", LogChannel::Debug, value, addr);
+                return;
+            }
+
+            MMIOWrite(mapping, index, value);
+        }
+        else if (addr < NV_USER_START)
+            WriteRAMIN32(addr - NV1_PRAMIN_START, value);
+        else
+            PFIFOCache1Push(NV1_USER_CHANNEL(addr), NV1_USER_METHOD(addr), value);
+    };
+}
@@ -27,6 +27,10 @@ namespace NV1Sim
                 game.last_tick_time = time_now;
             }
 
+            // Without the puller thread, whatever is left in CACHE1 gets executed once per frame
+            if (!gpu->settings.pfifo_thread)
+                gpu->PFIFOUpdate();
+
             SDL_RenderClear(game.renderer);
 
             Game_RenderLevel();
@@ -3,10 +3,17 @@
 #include <core/logging/logging.hpp>
 
 // Core STL
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
 #include <cstdint>
 #include <cstdlib>
+#include <span>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #define APP_NAME "Nvidia NV1 Multimedia Accelerator Simulator"
 #define APP_VERSION "Pre-Alpha 0.1"
@@ -1,14 +1,81 @@
-// 
+//
 // The NV1 emulator (The real one!)
 // Various utility methods
 //
 
 #pragma once
 
+#include <concepts>
 #include <cstdint>
 
 namespace NV1Sim
 {
-    uint8_t Util_Gray2Binary(uint32_t gray);                // Convert a gray code number into binary
-    uint8_t Util_Binary2Gray(uint32_t gray);                // Convert binary code number into gray
-}
\ No newline at end of file
+    // Convert binary code number into gray
+    template <std::unsigned_integral T> constexpr T Util_Binary2Gray(T binary)
+    {
+        return binary ^ (binary >> 1);
+    }
+
+    // Convert a gray code number into binary. Every bit is the XOR of all the bits above it, which is done in log2(width) steps
+    template <std::unsigned_integral T> constexpr T Util_Gray2Binary(T gray)
+    {
+        gray ^= (gray >> 1);
+        gray ^= (gray >> 2);
+        gray ^= (gray >> 4);
+
+        if constexpr (sizeof(T) > 1)
+            gray ^= (gray >> 8);
+        if constexpr (sizeof(T) > 2)
+            gray ^= (gray >> 16);
+        if constexpr (sizeof(T) > 4)
+            gray ^= (gray >> 32);
+
+        return gray;
+    }
+
+    // Division that rounds down or up rather than towards zero. b has to be positive
+    template <std::signed_integral T> constexpr T Util_FloorDiv(T a, T b)
+    {
+        return (a >= 0) ? a / b : -((-a + b - 1) / b);
+    }
+
+    template <std::signed_integral T> constexpr T Util_CeilDiv(T a, T b)
+    {
+        return -Util_FloorDiv<T>(-a, b);
+    }
+
+    static_assert(Util_FloorDiv(-7, 2) == -4 && Util_FloorDiv(7, 2) == 3 && Util_CeilDiv(-7, 2) == -3 && Util_CeilDiv(7, 2) == 4);
+
+    // These replaced lookup tables for the 5-bit CACHE1 GET/PUT, so check every entry of the old tables still comes out the same
+    static_assert([]
+    {
+        constexpr uint8_t gray_table[32] =
+        {
+            0b000000, 0b000001, 0b000011, 0b000010, 0b000110, 0b000111, 0b000101, 0b000100, //0x07
+            0b001100, 0b001101, 0b001111, 0b001110, 0b001010, 0b001011, 0b001001, 0b001000, //0x0F
+            0b011000, 0b011001, 0b011011, 0b011010, 0b011110, 0b011111, 0b011101, 0b011100, //0x17
+            0b010100, 0b010101, 0b010111, 0b010110, 0b010010, 0b010011, 0b010001, 0b010000, //0x1F
+        };
+
+        constexpr uint8_t binary_table[32] =
+        {
+            0x00, 0x01, 0x03, 0x02, 0x07, 0x06, 0x04, 0x05, // 0x07 (0)
+            0x0F, 0x0E, 0x0C, 0x0D, 0x08, 0x09, 0x0B, 0x0A, // 0x0F (1000)
+            0x1F, 0x1E, 0x1C, 0x1D, 0x18, 0x19, 0x1B, 0x1A, // 0x17 (10000)
+            0x10, 0x11, 0x13, 0x12, 0x17, 0x16, 0x14, 0x15, // 0x1F (11000)
+        };
+
+        for (uint32_t value = 0; value < 32; value++)
+        {
+            if (Util_Binary2Gray(value) != gray_table[value]
+            || Util_Gray2Binary(value) != binary_table[value])
+                return false;
+        }
+
+        return true;
+    }());
+
+    // and that they work across the whole width of a type
+    static_assert(Util_Gray2Binary(Util_Binary2Gray(0xFFFFFFFFu)) == 0xFFFFFFFF
+    && Util_Gray2Binary(Util_Binary2Gray(UINT64_C(0x8000000000000001))) == UINT64_C(0x8000000000000001));
+}